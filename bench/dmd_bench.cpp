@@ -0,0 +1,206 @@
+// DMD loading microbenchmark: times every stage of DMD_Reader::load_model on
+// synthetic grids of increasing size and on real .dmd files, reporting
+// triangles per second and how each stage scales with the triangle count.
+//
+//   dmd_bench [file.dmd | directory]... [--repeat N] [--max-grid N] [--no-synthetic]
+
+#include "DMD_Mesh.h"
+#include "DMD_Writer.h"
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static constexpr std::array<const char*, 6> stageNames{"tokenize", "expand", "normals", "weld", "degenerates", "pack"};
+
+struct Sample
+{
+    std::string name;
+    std::string contents;
+    size_t triangles = 0;
+    std::array<double, stageNames.size()> seconds{}; // median per stage
+};
+
+template<typename F>
+static double timed(F&& function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// runs the load_model stages on an in-memory file, so disk speed is not measured
+static bool measure(Sample& sample, int numRepeats)
+{
+    std::array<std::vector<double>, stageNames.size()> runs;
+
+    for (int run = 0; run < numRepeats; ++run)
+    {
+        DMD_Mesh mesh;
+        std::vector<DMD_Vertex> vertices;
+        std::vector<uint32_t> indices;
+        vsg::ref_ptr<ModelData> model;
+        bool valid = true;
+
+        std::istringstream input(sample.contents);
+        runs[0].push_back(timed([&]() { valid = dmd_tokenize(input, mesh); }));
+        if (!valid)
+        {
+            return false;
+        }
+
+        runs[1].push_back(timed([&]() { vertices = dmd_expand_indices(mesh); }));
+        runs[2].push_back(timed([&]() { dmd_accumulate_normals(vertices); }));
+        runs[3].push_back(timed([&]() { indices = dmd_weld(vertices); }));
+        runs[4].push_back(timed([&]() { dmd_remove_degenerates(indices); }));
+        runs[5].push_back(timed([&]() { model = dmd_pack(vertices, indices); }));
+
+        sample.triangles = mesh.position_indices.size() / 3;
+    }
+
+    for (size_t stage = 0; stage < stageNames.size(); ++stage)
+    {
+        auto& times = runs[stage];
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        sample.seconds[stage] = times[times.size() / 2];
+    }
+
+    return true;
+}
+
+static void addFile(std::vector<Sample>& samples, const std::filesystem::path& file)
+{
+    std::ifstream input(file, std::ios::binary);
+    std::ostringstream contents;
+    contents << input.rdbuf();
+    if (input)
+    {
+        samples.push_back(Sample{file.filename().string(), contents.str()});
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    vsg::CommandLine arguments(&argc, argv);
+    const int numRepeats = std::max(1, arguments.value(5, "--repeat"));
+    const uint32_t maxGrid = arguments.value<uint32_t>(64, "--max-grid");
+    const bool synthetic = !arguments.read("--no-synthetic");
+    if (arguments.errors())
+    {
+        arguments.writeErrorMessages(std::cerr);
+        return 1;
+    }
+
+    // an N x N grid has (N + 1)^2 vertices, which dmd_pack indexes with 16 bits
+    if (maxGrid > 255)
+    {
+        std::cerr << "--max-grid " << maxGrid << " is too large, grids over 255 x 255 overflow the 16 bit index range\n";
+        return 1;
+    }
+
+    std::vector<Sample> samples;
+
+    // grids double in size up to --max-grid
+    if (synthetic)
+    {
+        for (uint32_t grid = 4; grid <= maxGrid; grid *= 2)
+        {
+            std::ostringstream contents;
+            dmd_write(contents, dmd_grid(grid, grid, 10.0f));
+            samples.push_back(Sample{vsg::make_string("grid ", grid, "x", grid), contents.str()});
+        }
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::filesystem::path path(argv[i]);
+        if (std::filesystem::is_directory(path))
+        {
+            for (auto& entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == ".dmd")
+                {
+                    addFile(samples, entry.path());
+                }
+            }
+        }
+        else
+        {
+            addFile(samples, path);
+        }
+    }
+
+    std::vector<Sample> measured;
+    for (Sample& sample : samples)
+    {
+        if (measure(sample, numRepeats))
+        {
+            measured.push_back(std::move(sample));
+        }
+        else
+        {
+            std::cerr << "Failed to parse " << sample.name << '\n';
+        }
+    }
+
+    // smallest first, so the scaling column compares neighbouring sizes
+    std::stable_sort(measured.begin(), measured.end(), [](const Sample& lhs, const Sample& rhs) { return lhs.triangles < rhs.triangles; });
+
+    std::cout << numRepeats << " runs per file, median times, throughput in thousand triangles per second\n";
+    std::cout << std::left << std::setw(24) << "file" << std::right << std::setw(10) << "triangles";
+    for (const char* name : stageNames)
+    {
+        std::cout << std::setw(13) << name;
+    }
+    std::cout << std::setw(13) << "total" << std::setw(9) << "scaling" << '\n';
+
+    const Sample* previous = nullptr;
+    for (const Sample& sample : measured)
+    {
+        std::cout << std::left << std::setw(24) << sample.name.substr(0, 23) << std::right << std::setw(10) << sample.triangles
+                  << std::fixed << std::setprecision(1);
+
+        double total = 0.0;
+        for (double seconds : sample.seconds)
+        {
+            total += seconds;
+            std::cout << std::setw(13) << (seconds > 0.0 ? sample.triangles / seconds / 1000.0 : 0.0);
+        }
+        std::cout << std::setw(13) << (total > 0.0 ? sample.triangles / total / 1000.0 : 0.0);
+
+        // exponent k of time ~ triangles^k against the previous, smaller file
+        double previousTotal = 0.0;
+        if (previous)
+        {
+            for (double seconds : previous->seconds)
+            {
+                previousTotal += seconds;
+            }
+        }
+
+        if (previous && previous->triangles > 0 && sample.triangles > previous->triangles && previousTotal > 0.0 && total > 0.0)
+        {
+            const double exponent = std::log(total / previousTotal) / std::log(static_cast<double>(sample.triangles) / previous->triangles);
+            std::cout << std::setw(9) << std::setprecision(2) << exponent;
+        }
+        else
+        {
+            std::cout << std::setw(9) << '-';
+        }
+        std::cout << '\n';
+
+        previous = &sample;
+    }
+
+    return 0;
+}
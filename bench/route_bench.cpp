@@ -0,0 +1,391 @@
+// Scene build benchmark: runs the CPU side of route loading without a window
+// or Vulkan device and reports time and resident memory per stage.
+//
+//   route_bench [route directory] [--repeat N] [--cold] [--subgraphs] [--occluder-radius R]
+
+#include "DMD_Reader.h"
+#include "FileIndex.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "Route.h"
+
+#include <vsg/all.h>
+
+#if defined(__unix__)
+#    include <fcntl.h>
+#    include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// VmRSS and VmHWM from /proc/self/status, in KiB
+static size_t readStatus(const std::string& field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, field.size(), field) == 0 && line.size() > field.size() && line[field.size()] == ':')
+        {
+            return std::stoul(line.substr(field.size() + 1));
+        }
+    }
+    return 0;
+}
+
+#if defined(__unix__)
+// asks the kernel to drop the cached pages of every file in the route
+static size_t dropFileCache(const std::string& directory)
+{
+    size_t numFiles = 0;
+    std::error_code error;
+    for (auto itr = std::filesystem::recursive_directory_iterator(directory, error); !error && itr != std::filesystem::recursive_directory_iterator(); itr.increment(error))
+    {
+        if (!itr->is_regular_file())
+        {
+            continue;
+        }
+
+        int fd = ::open(itr->path().c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            continue;
+        }
+        ::fdatasync(fd);
+        if (::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0)
+        {
+            ++numFiles;
+        }
+        ::close(fd);
+    }
+    return numFiles;
+}
+#endif
+
+struct StageResult
+{
+    std::string name;
+    double milliseconds;
+    int64_t rssDelta; // KiB
+    size_t count;     // items processed by the stage
+};
+
+class SceneBuild
+{
+public:
+    SceneBuild(const std::string& in_routePath, bool in_subgraphs, double in_occluderRadius)
+        : routePath(in_routePath), subgraphs(in_subgraphs), occluderRadius(in_occluderRadius)
+    {
+    }
+
+    // of the last run, summed over all headings
+    size_t numCandidates = 0;
+    size_t numOccluded = 0;
+
+    std::vector<StageResult> run()
+    {
+        results.clear();
+
+        auto reader = DMD_Reader::create();
+        auto options = vsg::Options::create();
+        options->add(reader);
+        options->sharedObjects = vsg::SharedObjects::create();
+
+        auto fileIndex = FileIndex::create();
+        options->findFileCallback = fileIndex->findFileCallback();
+
+        auto route = Route::create(reader->assets);
+
+        stage("file index", [&]() {
+            fileIndex->add(routePath);
+            return fileIndex->size();
+        });
+
+        stage("route parse", [&]() {
+            route->loadObjectsRef(routePath);
+            return route->objectsRef.size();
+        });
+
+        stage("ref resolution", [&]() {
+            route->loadRouteMap(routePath);
+            return route->objectTransformations.size();
+        });
+
+        // every model a placement uses, parsed once like the pager would
+        std::vector<vsg::ref_ptr<ModelData>> models;
+        std::vector<vsg::dsphere> modelBounds(reader->assets->numModels()); // model space, radius < 0 when not parsed
+        stage("dmd parse", [&]() {
+            size_t numTriangles = 0;
+            for (uint32_t modelId = 0; modelId < reader->assets->numModels(); ++modelId)
+            {
+                if (reader->assets->model(modelId).useCount == 0)
+                {
+                    continue;
+                }
+
+                const vsg::Path modelFile = vsg::findFile(reader->assets->modelPath(modelId), options);
+                if (auto model = modelFile ? DMD_Reader::load_model(modelFile) : vsg::ref_ptr<ModelData>())
+                {
+                    numTriangles += model->indices->size() / 3;
+                    models.push_back(model);
+
+                    vsg::box bounds;
+                    for (const vsg::vec3& vertex : *model->vertices)
+                    {
+                        bounds.add(vertex);
+                    }
+                    modelBounds[modelId].set(vsg::dvec3((bounds.min + bounds.max) * 0.5f), vsg::length(bounds.max - bounds.min) * 0.5);
+                }
+            }
+            return numTriangles;
+        });
+        models.clear();
+
+        auto sceneGraph = vsg::Group::create();
+        std::vector<PagedObject> pagedObjects;
+        stage("paged graph", [&]() {
+            route->createPagedObjects(options, *sceneGraph, pagedObjects);
+            return pagedObjects.size();
+        });
+
+        auto culler = FrustumCuller::create();
+        stage("frustum build", [&]() {
+            std::vector<vsg::dsphere> bounds;
+            bounds.reserve(pagedObjects.size());
+            for (const PagedObject& object : pagedObjects)
+            {
+                bounds.emplace_back(object.center, object.radius);
+            }
+            culler->build(bounds);
+            return culler->size();
+        });
+
+        // the camera turns on the spot in the middle of the route, one frustum per heading
+        vsg::dbox extents;
+        for (const PagedObject& object : pagedObjects)
+        {
+            extents.add(object.center);
+        }
+        const vsg::dvec3 eye = pagedObjects.empty() ? vsg::dvec3(0.0, 0.0, 3.0) : (extents.min + extents.max) * 0.5 + vsg::dvec3(0.0, 0.0, 3.0);
+        auto perspective = vsg::Perspective::create(60.0, 1.25, 1.0, 10000.0);
+
+        std::vector<vsg::dmat4> views;
+        std::vector<FrustumCuller::Planes> frusta;
+        for (int i = 0; i < numHeadings; ++i)
+        {
+            const double angle = 2.0 * vsg::PI * i / numHeadings;
+            auto lookAt = vsg::LookAt::create(eye, eye + vsg::dvec3(std::cos(angle), std::sin(angle), 0.0), vsg::dvec3(0.0, 0.0, 1.0));
+            views.push_back(perspective->transform() * lookAt->transform());
+            frusta.push_back(FrustumCuller::frustumPlanes(views.back()));
+        }
+
+        // items are visible placements summed over all headings, both kernels must agree
+        const bool avx2 = FrustumCuller::avx2Supported();
+        for (bool useAvx2 : {false, true})
+        {
+            if (useAvx2 && !avx2)
+            {
+                continue;
+            }
+            culler->useAvx2 = useAvx2;
+            stage(useAvx2 ? "frustum avx2" : "frustum scalar", [&]() {
+                size_t numVisible = 0;
+                for (const FrustumCuller::Planes& planes : frusta)
+                {
+                    numVisible += culler->cull(planes);
+                }
+                return numVisible;
+            });
+        }
+
+        // occludees use the real model bounds where the model parsed, the PagedLOD bound otherwise
+        std::vector<vsg::dsphere> placementBounds;
+        for (size_t i = 0; i < pagedObjects.size(); ++i)
+        {
+            const ObjectTransformation& transformation = route->objectTransformations[i];
+            const vsg::dsphere& bound = modelBounds[route->objectsRef[transformation.referenceId].modelId];
+            if (bound.radius >= 0.0)
+            {
+                placementBounds.emplace_back(Route::placementMatrix(transformation) * bound.center, bound.radius);
+            }
+            else
+            {
+                placementBounds.emplace_back(pagedObjects[i].center, pagedObjects[i].radius);
+            }
+        }
+
+        std::vector<Occluder> occluders;
+        stage("occluders", [&]() {
+            occluders = OcclusionCuller::createOccluders(*route, options, occluderRadius, 64);
+            return occluders.size();
+        });
+
+        // items are the placements hidden behind occluders, out of those left by the frustum
+        auto occlusionCuller = OcclusionCuller::create();
+        numCandidates = 0;
+        numOccluded = 0;
+        stage("occlusion", [&]() {
+            for (size_t view = 0; view < views.size(); ++view)
+            {
+                culler->cull(frusta[view]);
+                occlusionCuller->render(occluders, views[view], eye);
+                for (size_t i = 0; i < placementBounds.size(); ++i)
+                {
+                    if (culler->visible(i))
+                    {
+                        occlusionCuller->occluded(placementBounds[i]);
+                    }
+                }
+                numCandidates += occlusionCuller->numTested;
+                numOccluded += occlusionCuller->numOccluded;
+            }
+            return numOccluded;
+        });
+
+        if (subgraphs)
+        {
+            // the complete subgraph the pager would compile, pipelines need a shader set but no device
+            std::vector<vsg::ref_ptr<vsg::Object>> loaded;
+            stage("subgraphs", [&]() {
+                if (auto phong = vsg::createPhongShaderSet(options))
+                {
+                    reader->init(phong);
+                }
+                for (const ObjectRef& ref : route->objectsRef)
+                {
+                    if (reader->assets->model(ref.modelId).useCount > 0)
+                    {
+                        loaded.push_back(reader->read(vsg::make_string(ref.modelId, ".dmd"), Route::createRequestOptions(ref, options)));
+                    }
+                }
+                return loaded.size();
+            });
+        }
+
+        return results;
+    }
+
+private:
+    template<typename F>
+    void stage(const std::string& name, F&& function)
+    {
+        const size_t rssBefore = readStatus("VmRSS");
+        auto start = std::chrono::steady_clock::now();
+
+        const size_t count = function();
+
+        auto end = std::chrono::steady_clock::now();
+        const size_t rssAfter = readStatus("VmRSS");
+
+        results.push_back(StageResult{name, std::chrono::duration<double, std::milli>(end - start).count(),
+                                      static_cast<int64_t>(rssAfter) - static_cast<int64_t>(rssBefore), count});
+    }
+
+    static constexpr int numHeadings = 16;
+
+    std::string routePath;
+    bool subgraphs;
+    double occluderRadius;
+    std::vector<StageResult> results;
+};
+
+int main(int argc, char* argv[])
+{
+    vsg::CommandLine arguments(&argc, argv);
+    const int numRepeats = std::max(1, arguments.value(5, "--repeat"));
+    bool cold = arguments.read("--cold");
+    const bool subgraphs = arguments.read("--subgraphs");
+    const double occluderRadius = arguments.value<double>(0.0, "--occluder-radius"); // also occlude with models this big
+    if (arguments.errors())
+    {
+        arguments.writeErrorMessages(std::cerr);
+        return 1;
+    }
+
+#if !defined(__unix__)
+    if (cold)
+    {
+        std::cerr << "--cold needs posix_fadvise, running warm" << '\n';
+        cold = false;
+    }
+#endif
+
+    const std::string routePath = argc > 1 ? argv[1] : "../routes/rostov-kavkazskaya";
+    if (!std::filesystem::is_directory(routePath))
+    {
+        std::cerr << "No route directory " << routePath << '\n';
+        return 1;
+    }
+
+    SceneBuild sceneBuild(routePath, subgraphs, occluderRadius);
+
+    if (!cold)
+    {
+        // warm mode reads the route once untimed, so every run hits the page cache
+        sceneBuild.run();
+    }
+
+    std::map<std::string, std::vector<StageResult>> stages;
+    std::vector<std::string> order;
+
+    for (int run = 0; run < numRepeats; ++run)
+    {
+#if defined(__unix__)
+        if (cold && dropFileCache(routePath) == 0)
+        {
+            std::cerr << "Failed to drop the file cache of " << routePath << '\n';
+        }
+#endif
+
+        for (const StageResult& result : sceneBuild.run())
+        {
+            if (stages.count(result.name) == 0)
+            {
+                order.push_back(result.name);
+            }
+            stages[result.name].push_back(result);
+        }
+    }
+
+    std::cout << routePath << ", " << numRepeats << (cold ? " cold" : " warm") << " runs\n";
+    std::cout << std::left << std::setw(16) << "stage" << std::right << std::setw(10) << "items" << std::setw(12) << "min ms"
+              << std::setw(12) << "median ms" << std::setw(12) << "max ms" << std::setw(16) << "median rss KiB" << '\n';
+
+    double total = 0.0;
+    for (const std::string& name : order)
+    {
+        auto& results = stages[name];
+        std::sort(results.begin(), results.end(), [](const StageResult& lhs, const StageResult& rhs) { return lhs.milliseconds < rhs.milliseconds; });
+        const StageResult& median = results[results.size() / 2];
+        total += median.milliseconds;
+
+        // the rss growth has its own median, it doesn't follow the run with the median time
+        std::vector<int64_t> rssDeltas;
+        for (const StageResult& result : results)
+        {
+            rssDeltas.push_back(result.rssDelta);
+        }
+        std::nth_element(rssDeltas.begin(), rssDeltas.begin() + rssDeltas.size() / 2, rssDeltas.end());
+
+        std::cout << std::left << std::setw(16) << name << std::right << std::setw(10) << median.count << std::fixed << std::setprecision(2)
+                  << std::setw(12) << results.front().milliseconds << std::setw(12) << median.milliseconds << std::setw(12) << results.back().milliseconds
+                  << std::setw(16) << rssDeltas[rssDeltas.size() / 2] << '\n';
+    }
+
+    if (sceneBuild.numCandidates > 0)
+    {
+        std::cout << "occlusion culled " << sceneBuild.numOccluded << " of " << sceneBuild.numCandidates << " placements in the frustum ("
+                  << (100.0 * sceneBuild.numOccluded / sceneBuild.numCandidates) << "%)\n";
+    }
+    std::cout << "total " << total << " ms (median), peak rss " << (readStatus("VmHWM") / 1024) << " MiB" << std::endl;
+    return 0;
+}
@@ -1,25 +1,24 @@
 #ifndef APPLICATION_H
 #define APPLICATION_H
 
+#include "CameraPath.h"
+#include "DMD_Reader.h"
+#include "FileIndex.h"
+#include "FrameStats.h"
+#include "FrustumCuller.h"
+#include "LodController.h"
+#include "MemoryStats.h"
+#include "OcclusionCuller.h"
+#include "OffscreenTarget.h"
+#include "PagingScheduler.h"
+#include "PhaseTimer.h"
+#include "PipelineCache.h"
+#include "ResidencyManager.h"
+#include "Route.h"
+
 #include <vsg/all.h>
 #include <vsgXchange/all.h>
 
-struct ObjectRef
-{
-    std::string label;
-    std::string modelPath;
-    std::string texturePath;
-    bool mipmap;
-    bool smooth;
-};
-
-struct ObjectTransformation
-{
-    ObjectRef* reference;
-    vsg::dvec3 translation;
-    vsg::dvec3 rotation;
-};
-
 class Application
 {
 public:
@@ -40,32 +39,89 @@ private:
     void createLights();
     void createView();
 
-    void loadObjectsRef(const std::string& routePath);
-    void loadRouteMap(const std::string& routePath);
+    void loadRoute(const std::string& routePath);
+
+    void createCameraPath();
+    void createTextureAtlas();
+    void preloadTextures(const vsg::dvec3& center, double radius);
 
     void initializeWindow();
+    vsg::ref_ptr<vsg::Window> createWindow();
     void initializeCamera();
     void initializeCommandGraph();
     void initializeViewer();
+    void createPagedObjects();
+    void distributeTiles(const vsg::Group& placements);
+
+    // culls every placement against the camera frustum and the sun's shadow volume in one pass each and switches
+    // the hidden ones off
+    void cullPlacements();
+
+    // gives the placements of newly loaded models their real bounds, in the PagedLOD, the culler and the tiles
+    void refreshPlacementBounds();
+
+    // prints MemoryStats, on the memory report key or with --memory-report at exit
+    void printMemoryReport();
 
 private:
     vsg::CommandLine arguments;
+    bool benchmark = false;
+    bool headless = false;
+    PhaseTimer startupTimer;
+    FrameStats frameStats;
     vsg::ref_ptr<vsg::Options> options;
+    vsg::ref_ptr<DMD_Reader> reader;
+    vsg::ref_ptr<FileIndex> fileIndex;
 
     vsg::ref_ptr<vsg::Group> sceneGraph;
     vsg::ref_ptr<vsg::Window> window;
+    vsg::ref_ptr<OffscreenTarget> offscreenTarget;
+    VkExtent2D extent{1280, 1024};
+    uint32_t recordThreads = 0; // secondary command graphs, 0 records everything in the primary
+    bool recordComparison = false; // --record-threads given, every thread count records without shadow maps
+    double tileSize = 500.0;
+    bool simdCull = false;
+    double cullMargin = 0.0; // widens the frustum and shadow volume planes
+    vsg::Path captureFile;
     vsg::ref_ptr<vsg::Camera> camera;
     vsg::ref_ptr<vsg::View> view;
     vsg::ref_ptr<vsg::CommandGraph> commandGraph;
+    std::vector<vsg::ref_ptr<vsg::SecondaryCommandGraph>> secondaryCommandGraphs;
+    std::vector<vsg::ref_ptr<vsg::Group>> recordGroups;
     vsg::ref_ptr<vsg::Viewer> viewer;
+    vsg::ref_ptr<PipelineCache> pipelineCache;
+    vsg::ref_ptr<vsg::DatabasePager> databasePager;
+    vsg::ref_ptr<PagingScheduler> pagingScheduler;
+    vsg::ref_ptr<ResidencyManager> residencyManager;
+    vsg::ref_ptr<LodController> lodController;
+    vsg::ref_ptr<FrustumCuller> frustumCuller;
+    vsg::ref_ptr<vsg::Switch> placementSwitch; // one child per paged object, in the same order
+    double numCulledFrames = 0.0;
+    double numVisibleSum = 0.0;
+    double numCasterSum = 0.0;
+    std::vector<uint64_t> casterBits;
+
+    bool occlusion = false;
+    vsg::ref_ptr<OcclusionCuller> occlusionCuller;
+    std::vector<Occluder> occluders;
+    double numTestedSum = 0.0;
+    double numOccludedSum = 0.0;
+    vsg::ref_ptr<MemoryStats> memoryStats;
+    vsg::ref_ptr<MemoryReportHandler> memoryReportHandler;
 
     vsg::ref_ptr<vsg::LookAt> lookAt;
     vsg::ref_ptr<vsg::SpotLight> spotLight;
     vsg::ref_ptr<vsg::CullGroup> cullGroup;
     vsg::ref_ptr<vsg::DirectionalLight> sunLight;
-
-    std::vector<ObjectRef> objectsRef;
-    std::vector<ObjectTransformation> objectTransformations;
+    vsg::ref_ptr<CameraPath> cameraPath;
+
+    vsg::ref_ptr<Route> route;
+    std::vector<PagedObject> pagedObjects;
+    std::vector<std::vector<uint32_t>> modelPlacements; // indexed by model id, until the model's bounds are known
+    std::vector<uint32_t> pendingModels;
+    std::vector<vsg::ref_ptr<vsg::CullGroup>> placementTiles; // with --record-threads, the tile of every placement
+    std::vector<uint32_t> visibleTextures;  // reused every frame
+    std::vector<uint32_t> residentTextures; // reused every frame
 };
 
 #endif // APPLICATION_H
@@ -0,0 +1,83 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include <vsg/all.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class LoadState : uint8_t
+{
+    Unloaded,
+    Loaded,
+    Failed
+};
+
+struct AssetInfo
+{
+    vsg::Path path;
+    uint32_t useCount = 0; // placements referencing the asset
+    LoadState state = LoadState::Unloaded;
+    size_t bytes = 0;
+    vsg::box bounds; // models only, in model space
+};
+
+// Interns the model and texture paths of a route to dense IDs and keeps their
+// metadata. Paths are interned while the route is parsed, so path lookups from
+// the pager threads are read only; metadata updates are synchronized.
+class AssetRegistry : public vsg::Inherit<vsg::Object, AssetRegistry>
+{
+public:
+    uint32_t internModel(const vsg::Path& path);
+    uint32_t internTexture(const vsg::Path& path);
+
+    const vsg::Path& modelPath(uint32_t id) const { return models[id].path; }
+    const vsg::Path& texturePath(uint32_t id) const { return textures[id].path; }
+
+    AssetInfo model(uint32_t id) const;
+    AssetInfo texture(uint32_t id) const;
+
+    // bounds of a loaded model without copying its path, false until the model has loaded
+    bool modelBounds(uint32_t id, vsg::box& bounds) const;
+
+    void addUse(uint32_t modelId, uint32_t textureId);
+    void modelLoaded(uint32_t id, const vsg::box& bounds, size_t bytes);
+    void textureLoaded(uint32_t id, size_t bytes);
+
+    // true the first time an asset fails, so the failure is reported once
+    bool modelFailed(uint32_t id);
+    bool textureFailed(uint32_t id);
+
+    LoadState modelState(uint32_t id) const;
+    LoadState textureState(uint32_t id) const;
+
+    size_t numModels() const { return models.size(); }
+    size_t numTextures() const { return textures.size(); }
+
+private:
+    static uint32_t intern(const vsg::Path& path, std::vector<AssetInfo>& assets, std::unordered_map<std::string, uint32_t>& ids);
+
+    mutable std::mutex mutex;
+    std::vector<AssetInfo> models;
+    std::vector<AssetInfo> textures;
+    std::unordered_map<std::string, uint32_t> modelIds;
+    std::unordered_map<std::string, uint32_t> textureIds;
+};
+
+// Identifies what a PagedLOD loads. It is attached to the Options of the
+// PagedLOD, so every placement of the same object ref shares one request.
+struct DMD_Request : public vsg::Inherit<vsg::Object, DMD_Request>
+{
+    static constexpr const char* key = "DMD_Request";
+
+    uint32_t modelId = 0;
+    uint32_t textureId = 0;
+    bool mipmap = false;
+    bool smooth = false;
+
+    int compare(const vsg::Object& rhs) const override;
+};
+
+#endif // ASSET_REGISTRY_H
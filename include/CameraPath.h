@@ -0,0 +1,40 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <vsg/all.h>
+
+#include <vector>
+
+// Time stamped camera positions used to replay identical benchmark runs. A path
+// is either recorded from an interactive session or generated along the route.
+class CameraPath : public vsg::Inherit<vsg::Object, CameraPath>
+{
+public:
+    struct Key
+    {
+        double time;
+        vsg::dvec3 eye;
+        vsg::dvec3 center;
+    };
+
+    std::vector<Key> keys;
+
+    // gaps follow() bridged, and the longest of them in metres
+    size_t numGaps = 0;
+    double longestGap = 0.0;
+
+    // one "time eye.x eye.y eye.z center.x center.y center.z" line per key
+    static vsg::ref_ptr<CameraPath> read(const vsg::Path& file);
+    bool write(const vsg::Path& file) const;
+
+    // drives along a polyline through the placements at a constant speed (m/s), flying straight across the
+    // gaps where the route has no placements for more than four cells
+    static vsg::ref_ptr<CameraPath> follow(const std::vector<vsg::dvec3>& placements, double speed, double height, double cellSize = 100.0);
+
+    void add(double time, const vsg::dvec3& eye, const vsg::dvec3& center);
+    void sample(double time, vsg::dvec3& eye, vsg::dvec3& center) const;
+
+    double duration() const { return keys.empty() ? 0.0 : keys.back().time; }
+};
+
+#endif // CAMERA_PATH_H
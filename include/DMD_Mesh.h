@@ -0,0 +1,43 @@
+#ifndef DMD_MESH_H
+#define DMD_MESH_H
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+struct ModelData : public vsg::Inherit<vsg::Object, ModelData>
+{
+    vsg::ref_ptr<vsg::vec3Array> vertices;
+    vsg::ref_ptr<vsg::vec3Array> normals;
+    vsg::ref_ptr<vsg::vec2Array> tex_coords;
+    vsg::ref_ptr<vsg::vec4Array> colors;
+    vsg::ref_ptr<vsg::ushortArray> indices;
+};
+
+// contents of a .dmd file, indices are zero based
+struct DMD_Mesh
+{
+    std::vector<vsg::vec3> positions;
+    std::vector<uint32_t> position_indices;
+    std::vector<vsg::vec2> tex_coords;
+    std::vector<uint32_t> tex_coord_indices;
+};
+
+struct DMD_Vertex
+{
+    vsg::vec3 pos;
+    vsg::vec3 normal;
+    vsg::vec2 tex_coord;
+};
+
+// the stages of DMD_Reader::load_model in order, separate so they can be benchmarked
+bool dmd_tokenize(std::istream& input, DMD_Mesh& mesh);
+std::vector<DMD_Vertex> dmd_expand_indices(const DMD_Mesh& mesh);
+void dmd_accumulate_normals(std::vector<DMD_Vertex>& vertices);
+std::vector<uint32_t> dmd_weld(std::vector<DMD_Vertex>& vertices);
+void dmd_remove_degenerates(std::vector<uint32_t>& indices);
+vsg::ref_ptr<ModelData> dmd_pack(const std::vector<DMD_Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+#endif // DMD_MESH_H
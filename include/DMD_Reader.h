@@ -1,35 +1,66 @@
 #ifndef DMD_READER_H
 #define DMD_READER_H
 
+#include "AssetRegistry.h"
+#include "DMD_Mesh.h"
+#include "MemoryStats.h"
+#include "PipelineCache.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "TextureDecodePool.h"
+
 #include <vsg/all.h>
 
+#include <array>
+#include <map>
+#include <mutex>
 #include <string>
-
-struct ModelData : public vsg::Inherit<vsg::Object, ModelData>
-{
-    vsg::ref_ptr<vsg::vec3Array> vertices;
-    vsg::ref_ptr<vsg::vec3Array> normals;
-    vsg::ref_ptr<vsg::vec2Array> tex_coords;
-    vsg::ref_ptr<vsg::vec4Array> colors;
-    vsg::ref_ptr<vsg::ushortArray> indices;
-};
+#include <vector>
 
 class DMD_Reader : public vsg::Inherit<vsg::ReaderWriter, DMD_Reader>
 {
 public:
     vsg::ref_ptr<vsg::Object> read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options = {}) const override;
 
-    static void init();
+    void init(vsg::ref_ptr<vsg::ShaderSet> shaderSet);
+
+    // also limits the mip levels the atlas samplers use to what the atlas padding supports
+    void set_texture_atlas(vsg::ref_ptr<TextureAtlas> atlas);
+
+    // shader stages of every pipeline variant, for precompiling them
+    vsg::ShaderStages shaderStages() const;
+
+    vsg::ref_ptr<AssetRegistry> assets = AssetRegistry::create();
+    vsg::ref_ptr<TextureAtlas> textureAtlas;
+    vsg::ref_ptr<TextureCache> textureCache = TextureCache::create();
+    vsg::ref_ptr<TextureDecodePool> decodePool;
+    vsg::ref_ptr<MemoryStats> memoryStats;
+
+    // parses a .dmd file into welded vertex arrays, needs no pipeline or device
+    static vsg::ref_ptr<ModelData> load_model(const vsg::Path& model_file);
 
 private:
-    vsg::ref_ptr<ModelData> load_model(const vsg::Path& model_file) const;
     void remove_carriage_return_symbols(std::string& str) const;
 
-    static vsg::ref_ptr<vsg::DescriptorSetLayout>  descriptorSetLayout;
-    static vsg::ref_ptr<vsg::PipelineLayout>       pipelineLayout;
-    static vsg::ref_ptr<vsg::BindGraphicsPipeline> bindGraphicsPipeline;
+    // pipelines are created once in init() and shared by every object, keyed by textured, mipmap and alpha test
+    struct PipelineVariant
+    {
+        vsg::ref_ptr<vsg::GraphicsPipelineConfigurator> config;
+        vsg::ref_ptr<BindCachedGraphicsPipeline> bindGraphicsPipeline;
+        vsg::StateCommands viewStateCommands;
+        vsg::ref_ptr<vsg::Sampler> sampler;
+        vsg::ref_ptr<vsg::Sampler> atlasSampler;
+        uint32_t baseAttributeBinding = 0;
+    };
+
+    static size_t pipeline_variant_index(bool textured, bool mipmap, bool alpha_test);
+    vsg::StateCommands bind_descriptors(size_t variant_index, vsg::ref_ptr<vsg::Data> texture_data, bool atlas) const;
+
+    std::array<PipelineVariant, 8> pipeline_variants;
 
-    // static std::map<vsg::Path, vsg::ref_ptr<vsg::StateGroup>> state_groups;
+    mutable std::mutex descriptor_mutex;
+    mutable std::map<std::pair<const vsg::Data*, size_t>, std::vector<vsg::observer_ptr<vsg::StateCommand>>> descriptor_binds;
+    mutable size_t descriptor_binds_pruned_size = 0;
 };
 
 #endif // DMD_READER_H
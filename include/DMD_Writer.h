@@ -0,0 +1,19 @@
+#ifndef DMD_WRITER_H
+#define DMD_WRITER_H
+
+#include "DMD_Mesh.h"
+
+#include <ostream>
+
+// writes the subset of the .dmd format dmd_tokenize() reads
+bool dmd_write(std::ostream& output, const DMD_Mesh& mesh);
+bool dmd_write(const vsg::Path& file, const DMD_Mesh& mesh);
+
+// rows x columns quads over a size x size square with a gentle bump, so faces
+// get distinct normals like real models, 2 * rows * columns triangles
+DMD_Mesh dmd_grid(uint32_t columns, uint32_t rows, float size);
+
+// closed box standing on z = 0, centred on the origin, 12 triangles
+DMD_Mesh dmd_box(float width, float depth, float height);
+
+#endif // DMD_WRITER_H
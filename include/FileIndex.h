@@ -0,0 +1,35 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include <vsg/all.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Snapshot of the files below a route directory. Lookups for paths inside an
+// indexed directory are answered from memory without touching the filesystem.
+class FileIndex : public vsg::Inherit<vsg::Object, FileIndex>
+{
+public:
+    // returns false when the directory can't be listed
+    bool add(const vsg::Path& directory);
+
+    bool covers(const vsg::Path& path) const;
+    vsg::Path find(const vsg::Path& path) const;
+
+    size_t size() const { return files.size(); }
+
+    // callback for vsg::Options::findFileCallback, falls back to the default search outside the indexed directories
+    vsg::Options::FindFileCallback findFileCallback();
+
+private:
+    static std::string normalize(const vsg::Path& path);
+    static std::string lowercase(std::string str);
+
+    std::vector<std::string> directories;
+    std::unordered_map<std::string, vsg::Path> files;
+    std::unordered_map<std::string, vsg::Path> lowercaseFiles;
+};
+
+#endif // FILE_INDEX_H
@@ -0,0 +1,60 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+struct FrameRecord
+{
+    uint64_t frameCount = 0;
+    double handleEvents = 0.0; // milliseconds
+    double update = 0.0;
+    double recordAndSubmit = 0.0;
+    double housekeeping = 0.0; // texture visibility, capture, paging and residency between record and present
+    double present = 0.0;
+    double total = 0.0;        // whole frame including advanceToNextFrame
+    uint32_t activeRequests = 0; // pager requests in flight at the end of the frame
+    uint32_t prefetched = 0;     // requests issued by the PagingScheduler during the frame
+};
+
+// Ring buffer of per-frame timings with percentile summaries and a hitch count,
+// both over the frames still in the buffer.
+class FrameStats
+{
+public:
+    explicit FrameStats(size_t in_capacity = 65536);
+
+    double hitchThreshold = 33.3; // milliseconds
+
+    void add(const FrameRecord& record);
+
+    struct Summary
+    {
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    Summary summary(double FrameRecord::*field) const;
+    size_t numHitches() const;
+    size_t size() const { return std::min(count, records.size()); }
+
+    // most recent frames first
+    const FrameRecord& recent(size_t index) const;
+
+    void print(std::ostream& out) const;
+    bool write(const vsg::Path& file) const; // .json or .csv
+
+private:
+    bool writeCsv(std::ostream& out) const;
+    bool writeJson(std::ostream& out) const;
+
+    std::vector<FrameRecord> records;
+    size_t count = 0;
+};
+
+#endif // FRAME_STATS_H
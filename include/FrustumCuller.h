@@ -0,0 +1,58 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <vsg/all.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// World-space bounding spheres of every placement in structure-of-arrays form,
+// culled against the six frustum planes in one linear pass into a visibility
+// bitset. With ROUTE_CULL_AVX2 and a CPU that supports it eight spheres are
+// tested per iteration, otherwise a scalar loop gives the same result.
+class FrustumCuller : public vsg::Inherit<vsg::Object, FrustumCuller>
+{
+public:
+    using Planes = std::array<vsg::dvec4, 6>;
+
+    // coordinates are stored as floats relative to the centre of the spheres
+    void build(const std::vector<vsg::dsphere>& spheres);
+
+    // replaces one sphere, once its real bounds are known
+    void set(size_t index, const vsg::dsphere& sphere);
+
+    // planes of a projection * view matrix with normals pointing inside, depth in [0, w] either way round
+    static Planes frustumPlanes(const vsg::dmat4& projectionView);
+
+    // planes bounding everything that can cast a shadow into the frustum up to shadowDistance from the eye:
+    // the frustum swept towards the light, lightDirection being the direction the light travels in
+    static Planes shadowCasterPlanes(const Planes& frustum, const vsg::dvec3& eye, double shadowDistance, const vsg::dvec3& lightDirection);
+
+    // margin widens every plane, in world units; returns the number of visible spheres
+    size_t cull(const Planes& planes, double margin = 0.0);
+
+    // the same into a bitset of the caller's, leaving bits() alone
+    size_t cull(const Planes& planes, std::vector<uint64_t>& bits, double margin = 0.0) const;
+
+    bool visible(size_t index) const { return ((visibility[index >> 6] >> (index & 63)) & 1) != 0; }
+    const std::vector<uint64_t>& bits() const { return visibility; }
+    size_t size() const { return count; }
+
+    static bool avx2Supported();
+    bool useAvx2 = avx2Supported();
+
+private:
+    vsg::dvec3 origin;
+    size_t count = 0;
+
+    // padded to a multiple of 64 with spheres that are never visible, so every bitset word is written whole
+    std::vector<float> centerX, centerY, centerZ, radius;
+    std::vector<uint64_t> visibility;
+};
+
+// kernels over padded arrays, planes as (nx, ny, nz, d) with n.p + d >= -r inside
+void cull_spheres_scalar(const float* x, const float* y, const float* z, const float* r, size_t count, const float (*planes)[4], uint64_t* bits);
+void cull_spheres_avx2(const float* x, const float* y, const float* z, const float* r, size_t count, const float (*planes)[4], uint64_t* bits);
+
+#endif // FRUSTUM_CULLER_H
@@ -0,0 +1,16 @@
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+#include <vsg/all.h>
+
+// Decodes an image file into an RGBA8 array owned by vsg. BMP files are flipped
+// so that all textures share the same texture coordinate origin. The "transparent"
+// value tells the reader whether the texture needs the alpha tested pipeline.
+vsg::ref_ptr<vsg::ubvec4Array2D> loadImage(const vsg::Path& file);
+
+// Reads only the image header.
+bool readImageSize(const vsg::Path& file, int& width, int& height);
+
+bool hasTransparency(const vsg::ubvec4Array2D& image);
+
+#endif // IMAGE_LOADER_H
@@ -0,0 +1,50 @@
+#ifndef LOD_CONTROLLER_H
+#define LOD_CONTROLLER_H
+
+#include "PagingScheduler.h"
+
+#include <vsg/all.h>
+
+#include <vector>
+
+// Holds a target frame time by scaling level of detail. The quality scale runs
+// from minimumScale to 1 (as configured): the PagedLOD screen height ratios are
+// divided by it and the shadow distance multiplied. Frame times inside the
+// hysteresis band around the target leave the scale alone, and every change is
+// followed by a cooldown so the loads it causes are not mistaken for load. The
+// pager backlog has its own band: above maxBacklog the scale drops, and it only
+// rises again once the backlog has fallen to minBacklog and nothing is pending.
+class LodController : public vsg::Inherit<vsg::Object, LodController>
+{
+public:
+    double targetFrameTime = 16.7; // ms
+    double hysteresis = 0.15;      // fraction of the target either side without changes
+    double minimumScale = 0.25;
+    double decreaseStep = 0.1;
+    double increaseStep = 0.05; // recover slower than degrading
+    uint32_t windowFrames = 30; // frames averaged per decision
+    uint32_t cooldownFrames = 60;
+    uint32_t maxBacklog = 32; // pending pager requests that count as overloaded
+    uint32_t minBacklog = 4;  // the most pending requests in a window that still allow an increase
+
+    // values at full quality
+    double baseRatio = 0.2;
+    double baseShadowDistance = 200.0;
+
+    // returns true when the scale changed and was applied
+    bool update(double frameTime, uint32_t activeRequests, const std::vector<PagedObject>& objects, vsg::ViewDependentState* viewDependentState);
+
+    void apply(const std::vector<PagedObject>& objects, vsg::ViewDependentState* viewDependentState) const;
+
+    double scale = 1.0;
+    size_t numDecreases = 0;
+    size_t numIncreases = 0;
+
+private:
+    double frameTimeSum = 0.0;
+    uint32_t backlogMax = 0;
+    uint32_t numSamples = 0;
+    uint32_t cooldown = 0;
+};
+
+#endif // LOD_CONTROLLER_H
@@ -0,0 +1,75 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include "PagingScheduler.h"
+
+#include <vsg/all.h>
+
+#include <atomic>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct MemoryReport
+{
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+    size_t textureCpuBytes = 0;
+    size_t textureGpuBytes = 0;
+    size_t numModels = 0;   // unique loaded subgraphs
+    size_t numTextures = 0; // unique textures of those subgraphs
+    size_t numResident = 0; // PagedLODs with their child loaded
+
+    std::map<std::string, size_t> nodes;   // unique scene graph nodes by class
+    std::map<std::string, size_t> objects; // unique state commands and arrays of those nodes by class
+};
+
+// Where the memory of a loaded route goes. DMD_Reader adds every subgraph it
+// creates to the running totals, update() counts the placements the pager
+// loads and expires each frame, the ResidencyManager the ones it evicts, and
+// collect() measures what is resident right now.
+class MemoryStats : public vsg::Inherit<vsg::Object, MemoryStats>
+{
+public:
+    std::atomic<size_t> modelsCreated{0};
+    std::atomic<size_t> vertexBytesCreated{0};
+    std::atomic<size_t> indexBytesCreated{0};
+
+    size_t placementsLoaded = 0;
+    size_t placementsExpired = 0; // including the evicted ones
+    size_t placementsEvicted = 0;
+    size_t bytesEvicted = 0;
+
+    void created(size_t vertexBytes, size_t indexBytes);
+    void evicted(size_t bytes);
+
+    // compares the placements with their state at the previous call, once per frame
+    void update(const std::vector<PagedObject>& objects);
+
+    // walks every placement and the whole scene graph, meant for on demand reports
+    MemoryReport collect(const std::vector<PagedObject>& objects, const vsg::Node* sceneGraph) const;
+
+    void print(std::ostream& out, const MemoryReport& report) const;
+
+private:
+    std::vector<bool> resident;
+};
+
+// asks for a memory report when the key is pressed
+class MemoryReportHandler : public vsg::Inherit<vsg::Visitor, MemoryReportHandler>
+{
+public:
+    vsg::KeySymbol key = vsg::KEY_m;
+    bool requested = false;
+
+    void apply(vsg::KeyPressEvent& keyPress) override
+    {
+        if (keyPress.keyBase == key)
+        {
+            requested = true;
+        }
+    }
+};
+
+#endif // MEMORY_STATS_H
@@ -0,0 +1,66 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "DMD_Mesh.h"
+#include "Route.h"
+
+#include <vsg/all.h>
+
+#include <vector>
+
+// Low-poly stand-in of a placement that hides what lies behind it. The
+// triangles are a subset of the real surface, so an occluder never hides
+// more than the full mesh would. Alpha tested placements, like fences and
+// foliage, are never occluders.
+struct Occluder
+{
+    vsg::ref_ptr<const vsg::vec3Array> triangles; // model space, three vertices per triangle, shared by placements of a model
+    vsg::dmat4 matrix;
+    vsg::dsphere bound; // world space
+};
+
+// Rasterizes the nearest occluders into a small reciprocal depth buffer and
+// tests bounding spheres against it, all on the CPU. A sphere is tested
+// against its screen rectangle grown by a pixel, so the coarse buffer never
+// hides a sphere that shows past an occluder's edge. The rasterizer and the
+// test work on four pixels at a time with SSE2 where it is available.
+class OcclusionCuller : public vsg::Inherit<vsg::Object, OcclusionCuller>
+{
+public:
+    // width is rounded up to a multiple of four
+    OcclusionCuller(uint32_t in_width = 256, uint32_t in_height = 128);
+
+    // clears the depth buffer and rasterizes up to maxOccluders of the occluders in the frustum, nearest first
+    void render(const std::vector<Occluder>& occluders, const vsg::dmat4& projectionView, const vsg::dvec3& eye);
+
+    // true when every pixel the sphere covers has an occluder in front of it
+    bool occluded(const vsg::dsphere& sphere);
+
+    // the largest triangles of a mesh, at most maxTriangles of them
+    static vsg::ref_ptr<vsg::vec3Array> createOccluderTriangles(const ModelData& model, size_t maxTriangles);
+
+    // occluders for placements of refs marked [occluder], and of any model whose bounding radius reaches
+    // minimumRadius when it is above zero, which parses every model the route uses; refs whose texture has
+    // transparent texels are skipped
+    static std::vector<Occluder> createOccluders(const Route& route, vsg::ref_ptr<const vsg::Options> options, double minimumRadius, size_t maxTriangles);
+
+    uint32_t width;
+    uint32_t height;
+    double nearDistance = 1.0;        // occluder triangles closer than this are skipped
+    double occluderDistance = 1000.0; // occluders further away are not rasterized
+    size_t maxOccluders = 128;
+
+    // since the last render()
+    size_t numOccluders = 0;
+    size_t numTriangles = 0;
+    size_t numTested = 0;
+    size_t numOccluded = 0;
+
+private:
+    void rasterizeTriangle(const vsg::vec4& c0, const vsg::vec4& c1, const vsg::vec4& c2);
+
+    vsg::dmat4 projectionView;
+    std::vector<float> depth; // 1/w, zero where no occluder has been drawn
+};
+
+#endif // OCCLUSION_CULLER_H
@@ -0,0 +1,39 @@
+#ifndef OFFSCREEN_TARGET_H
+#define OFFSCREEN_TARGET_H
+
+#include <vsg/all.h>
+
+// Colour and depth framebuffer on a device created without a surface, so the
+// renderer runs on machines without a display, software rasterizers included.
+// The colour attachment ends each frame in TRANSFER_SRC layout for captures.
+class OffscreenTarget : public vsg::Inherit<vsg::Object, OffscreenTarget>
+{
+public:
+    OffscreenTarget(const VkExtent2D& in_extent, bool debugLayer = false);
+
+    vsg::ref_ptr<vsg::RenderGraph> createRenderGraph(vsg::ref_ptr<vsg::View> view) const;
+
+    // copies the colour attachment into host visible memory, add after the render graph
+    vsg::ref_ptr<vsg::Commands> createCaptureCommands();
+
+    // waits for the device and writes the last captured frame as a binary PPM
+    bool writeCapture(const vsg::Path& file) const;
+
+    VkExtent2D extent;
+    VkFormat colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+
+    vsg::ref_ptr<vsg::Instance> instance;
+    vsg::ref_ptr<vsg::Device> device;
+    int queueFamily = -1;
+
+private:
+    vsg::ref_ptr<vsg::ImageView> createAttachment(VkFormat format, VkImageUsageFlags usage) const;
+    vsg::ref_ptr<vsg::RenderPass> createRenderPass() const;
+
+    vsg::ref_ptr<vsg::ImageView> colorImageView;
+    vsg::ref_ptr<vsg::Framebuffer> framebuffer;
+    vsg::ref_ptr<vsg::Image> captureImage;
+};
+
+#endif // OFFSCREEN_TARGET_H
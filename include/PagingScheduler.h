@@ -0,0 +1,57 @@
+#ifndef PAGING_SCHEDULER_H
+#define PAGING_SCHEDULER_H
+
+#include <vsg/all.h>
+
+#include <unordered_map>
+#include <vector>
+
+struct PagedObject
+{
+    vsg::ref_ptr<vsg::PagedLOD> pagedLod;
+    vsg::ref_ptr<vsg::MatrixTransform> transform; // parent of the PagedLOD
+    vsg::dvec3 center; // world space
+    double radius;
+    uint32_t modelId;   // AssetRegistry model
+    uint32_t textureId; // AssetRegistry texture
+};
+
+// Prefetches the objects the camera is about to reach, highest priority first
+// by projected size and by how far ahead of the direction of travel they are.
+// The priority is set before the request is queued and never changed while a
+// pager thread may read it. The pager's queue can't be edited from outside, so
+// nothing is cancelled: prefetches the camera has left behind are just no
+// longer kept alive, and the pager's reader discards them if they are still
+// stale when it takes them. Only the objects in the grid cells around the path
+// to the predicted camera position are visited each frame.
+class PagingScheduler : public vsg::Inherit<vsg::Object, PagingScheduler>
+{
+public:
+    double lookAheadTime = 4.0;          // seconds of travel to prefetch
+    double prefetchRadius = 250.0;       // around the predicted camera position
+    uint32_t maxPrefetchPerFrame = 16;
+    double cellSize = 250.0;             // of the grid the objects are looked up in, built on the first update
+
+    void update(const std::vector<PagedObject>& objects, vsg::DatabasePager& pager, const vsg::dvec3& eye, double time, uint64_t frameCount);
+
+    const vsg::dvec3& velocity() const { return cameraVelocity; }
+
+    size_t numPrefetched = 0;
+    size_t numAbandoned = 0; // queued prefetches left behind by the camera, which the pager discards if it reaches them stale
+
+private:
+    double priority(const PagedObject& object, const vsg::dvec3& eye, const vsg::dvec3& direction) const;
+    void buildGrid(const std::vector<PagedObject>& objects);
+
+    bool first = true;
+    vsg::dvec3 previousEye;
+    double previousTime = 0.0;
+    vsg::dvec3 cameraVelocity;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid; // object indices by cell
+    size_t gridSize = 0;                                       // objects the grid was built for
+    std::vector<uint64_t> aheadFrame;                          // last frame each object was ahead
+    std::vector<uint32_t> ahead;                               // objects ahead in the previous frame
+};
+
+#endif // PAGING_SCHEDULER_H
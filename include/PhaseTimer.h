@@ -0,0 +1,59 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <vsg/all.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Measures nested phases with the monotonic vsg::clock.
+class PhaseTimer
+{
+public:
+    class Scope
+    {
+    public:
+        Scope(PhaseTimer& in_timer, const std::string& name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PhaseTimer& timer;
+        size_t index;
+    };
+
+    PhaseTimer();
+
+    Scope scope(const std::string& name) { return Scope(*this, name); }
+
+    // returns whatever the function returns
+    template<typename F>
+    decltype(auto) measure(const std::string& name, F&& function)
+    {
+        Scope phase(*this, name);
+        return function();
+    }
+
+    void print(std::ostream& out) const;
+    bool writeJson(const vsg::Path& file) const;
+
+private:
+    struct Phase
+    {
+        std::string name;
+        uint32_t depth;
+        double start;    // seconds since the timer was created
+        double duration; // seconds
+    };
+
+    double now() const;
+
+    vsg::clock::time_point origin;
+    std::vector<Phase> phases;
+    uint32_t depth = 0;
+};
+
+#endif // PHASE_TIMER_H
@@ -0,0 +1,68 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#include <vsg/all.h>
+
+#include <mutex>
+#include <vector>
+
+// VkPipelineCache that persists between runs. The stored data is only reused
+// when its header matches the vendor, device and pipeline cache UUID of the
+// physical device it is loaded on.
+class PipelineCache : public vsg::Inherit<vsg::Object, PipelineCache>
+{
+public:
+    PipelineCache(vsg::ref_ptr<vsg::Device> in_device, const vsg::Path& in_file);
+    ~PipelineCache() override;
+
+    static constexpr const char* key = "PipelineCache";
+
+    VkPipelineCache vk() const { return pipelineCache; }
+    operator VkPipelineCache() const { return pipelineCache; }
+
+    bool save() const;
+
+    size_t loadedSize = 0;
+
+private:
+    bool validate(const std::vector<uint8_t>& data) const;
+
+    vsg::ref_ptr<vsg::Device> device;
+    vsg::Path file;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+};
+
+// Stands in for vsg::BindGraphicsPipeline, whose pipelines are always created
+// with VK_NULL_HANDLE: vsg 1.1 offers no way to hand a VkPipelineCache to its
+// own pipeline creation, so the cache covers the pipelines bound through this
+// class and not the shadow map or other vsg pipelines. The pipeline is only
+// used as a description; the VkPipelines are created per view through the
+// PipelineCache attached to the device under PipelineCache::key, or without a
+// cache when none is attached.
+class BindCachedGraphicsPipeline : public vsg::Inherit<vsg::StateCommand, BindCachedGraphicsPipeline>
+{
+public:
+    explicit BindCachedGraphicsPipeline(vsg::ref_ptr<vsg::GraphicsPipeline> in_pipeline = {});
+    ~BindCachedGraphicsPipeline() override;
+
+    vsg::ref_ptr<vsg::GraphicsPipeline> pipeline;
+
+    int compare(const vsg::Object& rhs) const override;
+
+    void compile(vsg::Context& context) override;
+    void record(vsg::CommandBuffer& commandBuffer) const override;
+    void release() override;
+
+private:
+    struct Compiled
+    {
+        vsg::ref_ptr<vsg::Device> device;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+    };
+
+    // indexed by view id and grown on demand, as vsg::GraphicsPipeline keeps its implementations
+    vsg::vk_buffer<Compiled> compiled;
+    std::mutex compileMutex;
+};
+
+#endif // PIPELINE_CACHE_H
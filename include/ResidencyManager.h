@@ -0,0 +1,53 @@
+#ifndef RESIDENCY_MANAGER_H
+#define RESIDENCY_MANAGER_H
+
+#include "MemoryStats.h"
+#include "PagingScheduler.h"
+
+#include <vsg/all.h>
+
+#include <deque>
+#include <vector>
+
+// Tracks the CPU and GPU bytes of the loaded PagedLOD children and expires the
+// least recently visible ones when the configured budget is exceeded. Far and
+// large children are preferred among those that were last seen equally long ago.
+// Subgraphs and textures shared by several placements are counted once and only
+// freed with the last placement that holds them. Children are expired through
+// the DatabasePager's PagedLODContainer, as the pager expires its own.
+class ResidencyManager : public vsg::Inherit<vsg::Object, ResidencyManager>
+{
+public:
+    size_t cpuBudget = 0; // bytes, 0 disables the budget
+    size_t gpuBudget = 0; // bytes, 0 disables the budget
+    uint64_t minimumIdleFrames = 60;
+
+    vsg::ref_ptr<vsg::SharedObjects> sharedObjects;
+    vsg::ref_ptr<vsg::DatabasePager> databasePager;
+    vsg::ref_ptr<MemoryStats> memoryStats; // told about every eviction
+
+    void update(const std::vector<PagedObject>& objects, const vsg::dvec3& eye, uint64_t frameCount);
+
+    // live counters
+    size_t numResident = 0;
+    size_t residentCpuBytes = 0;
+    size_t residentGpuBytes = 0;
+    size_t numEvicted = 0;
+    size_t evictedBytes = 0;
+
+    static void childBytes(const vsg::Node* node, size_t& cpuBytes, size_t& gpuBytes);
+    static const vsg::Data* childTexture(const vsg::Node* node, size_t& cpuBytes, size_t& gpuBytes);
+
+private:
+    struct Released
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        uint64_t frameCount;
+    };
+
+    // evicted subgraphs are released a few frames later, once no command buffer in flight uses them
+    std::deque<Released> released;
+    uint64_t lastPruneFrame = 0;
+};
+
+#endif // RESIDENCY_MANAGER_H
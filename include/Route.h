@@ -0,0 +1,65 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include "AssetRegistry.h"
+#include "PagingScheduler.h"
+
+#include <vsg/all.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ObjectRef
+{
+    std::string label;
+    uint32_t modelId;   // AssetRegistry model
+    uint32_t textureId; // AssetRegistry texture
+    bool mipmap;
+    bool smooth;
+    bool occluder; // inside an [occluder] section, hides what lies behind it
+};
+
+struct ObjectTransformation
+{
+    uint32_t referenceId; // index into objectsRef
+    vsg::dvec3 translation;
+    vsg::dvec3 rotation;
+};
+
+// Object references and placements of a route directory. Needs no Vulkan
+// device, so it is shared by the viewer and the scene build benchmark.
+class Route : public vsg::Inherit<vsg::Object, Route>
+{
+public:
+    explicit Route(vsg::ref_ptr<AssetRegistry> in_assets);
+
+    // objects.ref, interns the model and texture paths in the registry
+    bool loadObjectsRef(const std::string& routePath);
+
+    // route1.map, placements of labels unknown to objects.ref are skipped
+    bool loadRouteMap(const std::string& routePath);
+
+    // one PagedLOD per placement, placements of the same ref share the loaded subgraph; the PagedLOD bound is
+    // the model's when the registry already knows it, a sphere of defaultRadius otherwise
+    void createPagedObjects(vsg::ref_ptr<const vsg::Options> options, vsg::Group& sceneGraph, std::vector<PagedObject>& pagedObjects) const;
+
+    static vsg::dmat4 placementMatrix(const ObjectTransformation& transformation);
+
+    // model space sphere around a model's bounding box
+    static vsg::dsphere modelSphere(const vsg::box& bounds);
+
+    static vsg::ref_ptr<vsg::Options> createRequestOptions(const ObjectRef& ref, vsg::ref_ptr<const vsg::Options> options);
+
+    void clear();
+
+    vsg::ref_ptr<AssetRegistry> assets;
+    double minimumScreenHeightRatio = 0.2;
+    double defaultRadius = 100.0;
+
+    std::vector<ObjectRef> objectsRef;
+    std::unordered_map<std::string, uint32_t> objectRefIds;
+    std::vector<ObjectTransformation> objectTransformations;
+};
+
+#endif // ROUTE_H
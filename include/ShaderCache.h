@@ -0,0 +1,30 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <vsg/all.h>
+
+// Persistent SPIR-V cache. Shader stages are keyed by their GLSL source, entry
+// point, compile settings and the VSG version; stages found in the cache get
+// their code assigned so the viewer doesn't have to run glslang.
+class ShaderCache : public vsg::Inherit<vsg::Object, ShaderCache>
+{
+public:
+    explicit ShaderCache(const vsg::Path& in_directory);
+
+    vsg::Path directory;
+
+    // assigns cached code and compiles and stores the stages that are missing
+    bool apply(const vsg::ShaderStages& stages, vsg::ref_ptr<const vsg::Options> options = {});
+
+    size_t hits = 0;
+    size_t misses = 0;
+
+    static uint64_t hash(const vsg::ShaderStage& stage);
+
+private:
+    vsg::Path cacheFile(const vsg::ShaderStage& stage) const;
+    bool load(const vsg::Path& file, vsg::ShaderModule& module) const;
+    bool store(const vsg::Path& file, const vsg::ShaderModule& module) const;
+};
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,56 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <vsg/all.h>
+
+#include <map>
+#include <vector>
+
+struct AtlasRegion
+{
+    uint32_t page;
+    vsg::vec2 offset;
+    vsg::vec2 scale;
+};
+
+// Packs small textures into shared pages so that the objects using them can
+// share one descriptor set. Texture coordinates are remapped with the region
+// offset and scale.
+class TextureAtlas : public vsg::Inherit<vsg::Object, TextureAtlas>
+{
+public:
+    uint32_t maxTextureSize = 64;
+    uint32_t pageSize = 1024;
+    uint32_t padding = 2;
+
+    void build(std::vector<vsg::Path> texturePaths);
+    bool writeIndex(const vsg::Path& indexFile) const;
+
+    // mip levels beyond this would average texels of neighbouring textures, each level halves the padding
+    float maxLod() const;
+
+    const AtlasRegion* find(const vsg::Path& texturePath) const;
+    vsg::ref_ptr<vsg::Data> page(uint32_t index) const;
+
+    size_t numTextures() const { return regions.size(); }
+    size_t numPages() const { return pages.size(); }
+
+private:
+    struct Placement
+    {
+        vsg::Path path;
+        int width;
+        int height;
+        uint32_t page;
+        uint32_t x;
+        uint32_t y;
+    };
+
+    void copyToPage(const Placement& placement, const vsg::ubvec4Array2D& image);
+
+    std::vector<Placement> placements;
+    std::map<vsg::Path, AtlasRegion> regions;
+    std::vector<vsg::ref_ptr<vsg::ubvec4Array2D>> pages;
+};
+
+#endif // TEXTURE_ATLAS_H
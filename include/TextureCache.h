@@ -0,0 +1,75 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <vsg/all.h>
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Keeps the decoded route textures, applies the resolution cap and keeps the
+// estimated texture memory inside the budget by dropping the top mip levels of
+// the least recently visible textures. Textures are identified by their dense
+// AssetRegistry id, so the cache is an array rather than a map of paths. Only
+// textures no loaded placement has held for releaseFrames are reduced, dropped
+// or reloaded: the application marks the resident ones every frame, so other
+// references to the image, like descriptor sets or decode futures, don't count.
+class TextureCache : public vsg::Inherit<vsg::Object, TextureCache>
+{
+public:
+    uint32_t maxDimension = 0; // 0 disables the cap
+    size_t budget = 0;         // bytes, 0 disables the budget
+    uint32_t maxReduction = 4; // number of mip levels that can be dropped
+    uint64_t freshFrames = 300; // a newly decoded texture counts as used this many frames ahead, so preloads survive until seen
+    uint64_t releaseFrames = 8; // a texture stays in use this long after its last placement unloaded, for the frames in flight
+
+    std::atomic<uint64_t> frameCount{0};
+
+    // shared by every object whose texture is missing or can't be decoded
+    const vsg::ref_ptr<vsg::Data> placeholder = createPlaceholder();
+
+    // file is the resolved path of the texture
+    vsg::ref_ptr<vsg::Data> load(uint32_t textureId, const vsg::Path& file);
+
+    // decoded or failed
+    bool contains(uint32_t textureId) const;
+
+    // textures the record traversal drew this frame, eviction picks the least recently visible
+    void markVisible(const std::vector<uint32_t>& textureIds, uint64_t frame);
+
+    // textures of the placements whose child is loaded, the scene graph holds their images
+    void markResident(const std::vector<uint32_t>& textureIds, uint64_t frame);
+
+    size_t residentBytes() const;
+    void report(std::ostream& out) const;
+
+    static size_t estimateBytes(uint32_t width, uint32_t height);
+    static vsg::ref_ptr<vsg::Data> createPlaceholder();
+
+private:
+    struct Entry
+    {
+        vsg::Path file;
+        bool failed = false;
+        vsg::ref_ptr<vsg::ubvec4Array2D> image;
+        uint32_t width = 0;  // full resolution
+        uint32_t height = 0; // full resolution
+        uint32_t reduction = 0;
+        size_t bytes = 0;
+        uint64_t lastUsedFrame = 0;     // last visible, or the freshness horizon of a new decode
+        uint64_t lastResidentFrame = 0; // last held by a loaded placement, or the freshness horizon of a new decode
+    };
+
+    bool inUse(const Entry& entry) const { return entry.lastResidentFrame + releaseFrames >= frameCount; }
+
+    vsg::ref_ptr<vsg::ubvec4Array2D> decode(const vsg::Path& file, uint32_t& width, uint32_t& height) const;
+    void makeRoom(size_t bytes, uint32_t keep);
+    void reduce(Entry& entry);
+
+    mutable std::mutex mutex;
+    std::vector<Entry> entries; // indexed by texture id, grown on demand
+    size_t totalBytes = 0;
+};
+
+#endif // TEXTURE_CACHE_H
@@ -0,0 +1,53 @@
+#ifndef TEXTURE_DECODE_POOL_H
+#define TEXTURE_DECODE_POOL_H
+
+#include "TextureCache.h"
+
+#include <vsg/all.h>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Decodes textures ahead of the pager. Requests for a texture that is already
+// being decoded share the same decode, results are stored in the TextureCache.
+// Textures are keyed by their AssetRegistry id, file is the resolved path.
+class TextureDecodePool : public vsg::Inherit<vsg::Object, TextureDecodePool>
+{
+public:
+    explicit TextureDecodePool(vsg::ref_ptr<TextureCache> in_textureCache, uint32_t numThreads = 0);
+    ~TextureDecodePool() override;
+
+    void request(uint32_t textureId, const vsg::Path& file);
+    vsg::ref_ptr<vsg::Data> acquire(uint32_t textureId, const vsg::Path& file);
+
+    size_t pending() const;
+
+    vsg::ref_ptr<TextureCache> textureCache;
+
+private:
+    struct Task
+    {
+        std::promise<vsg::ref_ptr<vsg::Data>> promise;
+        std::shared_future<vsg::ref_ptr<vsg::Data>> future = promise.get_future().share();
+        bool started = false;
+    };
+
+    void run();
+    vsg::ref_ptr<vsg::Data> decode(uint32_t textureId, const vsg::Path& file, const std::shared_ptr<Task>& task);
+
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::pair<uint32_t, vsg::Path>> queue;
+    std::unordered_map<uint32_t, std::shared_ptr<Task>> tasks;
+    std::vector<std::thread> threads;
+    bool done = false;
+};
+
+#endif // TEXTURE_DECODE_POOL_H
@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <vsg/io/Path.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Scoped events written as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Every thread records into its own buffer; while disabled a scope costs one
+// relaxed atomic load. Names must be string literals, only the pointer is kept.
+class Trace
+{
+public:
+    static void enable(bool value) { active.store(value, std::memory_order_relaxed); }
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    // label of the calling thread in the trace, the first call per thread wins
+    static void nameThread(const char* name);
+
+    static bool write(const vsg::Path& file);
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char* in_name)
+            : name(enabled() ? in_name : nullptr)
+        {
+            if (name)
+            {
+                start = now();
+            }
+        }
+
+        ~Scope()
+        {
+            if (name)
+            {
+                record(name, start, now());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        int64_t start = 0;
+    };
+
+private:
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void record(const char* name, int64_t start, int64_t end);
+
+    static std::atomic_bool active;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACE_H
@@ -1,10 +1,14 @@
 #include "Application.h"
 
 #include "DMD_Reader.h"
+#include "ShaderCache.h"
+#include "Trace.h"
 
 #include <iostream>
+#include <map>
 #include <stdexcept>
 #include <chrono>
+#include <cmath>
 
 Application::Application(int* argc, char** argv)
     : arguments(argc, argv)
@@ -18,40 +22,269 @@ Application::Application(int* argc, char** argv)
 
 void Application::run()
 {
+    vsg::Path traceFile;
+    if (arguments.read("--trace", traceFile))
+    {
+        Trace::enable(true);
+        Trace::nameThread("main");
+    }
+
+    if (arguments.read("--compile-shaders"))
+    {
+        // warmup only, fill the shader cache with every variant the reader uses and exit
+        initializeOptions();
+        createShaderSet();
+        return;
+    }
+
     initialize();
     update();
+
+    if (pipelineCache && !pipelineCache->save())
+    {
+        std::cerr << "Failed to save the pipeline cache" << std::endl;
+    }
+
+    if (traceFile && !Trace::write(traceFile))
+    {
+        std::cerr << "Failed to write " << traceFile << '\n';
+    }
 }
 
 void Application::initialize()
 {
-    initializeOptions();
-    createShaderSet();
-    initializeWindow();
-    initializeCamera();
-    initializeSceneGraph();
-    createLights();
-    createView();
-    initializeCommandGraph();
-    initializeViewer();
+    vsg::Path startupJson;
+    arguments.read("--startup-json", startupJson);
+
+    // replays a camera path with a fixed time step so runs can be compared
+    benchmark = arguments.read("--benchmark");
+
+    // renders into an offscreen framebuffer, for machines without a display
+    headless = arguments.read("--headless");
+    if (arguments.read("--capture", captureFile) && !headless)
+    {
+        std::cerr << "--capture requires --headless, ignoring it" << std::endl;
+        captureFile = {};
+    }
+
+    // route tiles recorded into secondary command buffers on their own threads
+    recordComparison = arguments.read("--record-threads", recordThreads);
+    tileSize = arguments.value<double>(500.0, "--tile-size");
+    if (recordThreads > 0 && headless)
+    {
+        std::cerr << "--record-threads needs a window, recording on one thread" << std::endl;
+        recordThreads = 0;
+    }
+
+    // placements culled from a flat bounds array instead of by the record traversal
+    simdCull = arguments.read("--simd-cull");
+    cullMargin = arguments.value<double>(0.0, "--cull-margin");
+
+    // placements hidden behind occluders are switched off as well, which needs the flat cull
+    occlusion = arguments.read("--occlusion");
+    simdCull = simdCull || occlusion;
+    if (simdCull && recordThreads > 0)
+    {
+        std::cerr << "--simd-cull ignored with --record-threads, the tiles are culled by their CullGroups" << std::endl;
+        simdCull = false;
+    }
+
+    {
+        auto total = startupTimer.scope("initialize");
+        startupTimer.measure("options", [&]() { initializeOptions(); });
+        startupTimer.measure("shader set", [&]() { createShaderSet(); });
+        startupTimer.measure("window", [&]() { initializeWindow(); });
+        startupTimer.measure("camera", [&]() { initializeCamera(); });
+        startupTimer.measure("scene graph", [&]() { initializeSceneGraph(); });
+        startupTimer.measure("lights", [&]() { createLights(); });
+        startupTimer.measure("view", [&]() { createView(); });
+        startupTimer.measure("command graph", [&]() { initializeCommandGraph(); });
+        startupTimer.measure("viewer", [&]() { initializeViewer(); });
+    }
+
+    startupTimer.print(std::cout);
+    if (startupJson && !startupTimer.writeJson(startupJson))
+    {
+        std::cerr << "Failed to write " << startupJson << '\n';
+    }
 }
 
 void Application::update()
 {
     auto numFrames = arguments.value(-1, "-f");
+    if (headless && !benchmark && numFrames < 0)
+    {
+        // nothing can close a headless viewer
+        numFrames = 100;
+    }
+    bool textureReport = arguments.read("--texture-report");
+    bool memoryReport = arguments.read("--memory-report");
+
+    vsg::Path frameStatsFile;
+    arguments.read("--frame-stats", frameStatsFile);
+    frameStats.hitchThreshold = arguments.value<double>(33.3, "--hitch-ms");
+
+    const int captureInterval = arguments.value(0, "--capture-interval");
+
+    vsg::Path recordFile;
+    arguments.read("--record-camera", recordFile);
+    auto recordedPath = recordFile ? CameraPath::create() : vsg::ref_ptr<CameraPath>();
+
+    const double timeStep = 1.0 / arguments.value<double>(60.0, "--benchmark-fps");
+    if (benchmark && numFrames < 0)
+    {
+        numFrames = static_cast<int>(std::ceil(cameraPath->duration() / timeStep)) + 1;
+    }
 
     auto startTime = vsg::clock::now();
     double numFramesCompleted = 0.0;
 
-    while (viewer->advanceToNextFrame() && (numFrames < 0 || (numFrames--) > 0))
+    auto milliseconds = [](vsg::clock::time_point& timePoint) {
+        auto now = vsg::clock::now();
+        double elapsed = std::chrono::duration<double, std::chrono::milliseconds::period>(now - timePoint).count();
+        timePoint = now;
+        return elapsed;
+    };
+
+    auto frameStart = vsg::clock::now();
+    while (viewer->advanceToNextFrame(benchmark ? numFramesCompleted * timeStep : vsg::UseTimeSinceStartPoint) && (numFrames < 0 || (numFrames--) > 0))
     {
-        viewer->handleEvents();
-        viewer->update();
+        TRACE_SCOPE("frame");
+
+        FrameRecord record;
+        record.frameCount = viewer->getFrameStamp()->frameCount;
+        auto timePoint = vsg::clock::now();
+
+        {
+            TRACE_SCOPE("handleEvents");
+            viewer->handleEvents();
+        }
+        record.handleEvents = milliseconds(timePoint);
+
+        {
+            TRACE_SCOPE("update");
+            const double simulationTime = viewer->getFrameStamp()->simulationTime;
+            if (benchmark)
+            {
+                cameraPath->sample(simulationTime, lookAt->eye, lookAt->center);
+            }
+            else if (recordedPath)
+            {
+                recordedPath->add(simulationTime, lookAt->eye, lookAt->center);
+            }
+
+            {
+                TRACE_SCOPE("viewer update");
+                viewer->update();
+            }
+
+            reader->textureCache->frameCount = viewer->getFrameStamp()->frameCount;
+
+            if (!pendingModels.empty())
+            {
+                refreshPlacementBounds();
+            }
+
+            // the sun stays where createLights() put it while benchmarking
+            if (!benchmark)
+            {
+                auto duration = std::chrono::duration<double, std::chrono::seconds::period>(vsg::clock::now() - startTime).count();
+                sunLight->direction.set(cos(duration), -1.0, sin(duration));
+            }
+
+            // after the sun has moved, the shadow casters are culled against the direction it is recorded with
+            if (frustumCuller)
+            {
+                TRACE_SCOPE("frustum cull");
+                cullPlacements();
+            }
+        }
+        record.update = milliseconds(timePoint);
+
+        {
+            TRACE_SCOPE("recordAndSubmit");
+            viewer->recordAndSubmit();
+        }
+        record.recordAndSubmit = milliseconds(timePoint);
+
+        if (reader->textureCache->budget > 0)
+        {
+            // the texture budget evicts the least recently visible textures the scene graph doesn't hold, so stamp
+            // the ones just drawn and the ones of every loaded placement
+            TRACE_SCOPE("texture visibility");
+            const uint64_t frameCount = viewer->getFrameStamp()->frameCount;
+            visibleTextures.clear();
+            residentTextures.clear();
+            for (const PagedObject& object : pagedObjects)
+            {
+                if (object.pagedLod->children[0].node)
+                {
+                    residentTextures.push_back(object.textureId);
+                    if (object.pagedLod->frameHighResLastUsed.load() == frameCount)
+                    {
+                        visibleTextures.push_back(object.textureId);
+                    }
+                }
+            }
+            reader->textureCache->markVisible(visibleTextures, frameCount);
+            reader->textureCache->markResident(residentTextures, frameCount);
+        }
+
+        if (captureFile && captureInterval > 0 && record.frameCount % captureInterval == 0)
+        {
+            const vsg::Path frameFile = vsg::concatPaths(vsg::filePath(captureFile), vsg::make_string(vsg::simpleFilename(captureFile), "_", record.frameCount, ".ppm"));
+            if (!offscreenTarget->writeCapture(frameFile))
+            {
+                std::cerr << "Failed to write " << frameFile << '\n';
+            }
+        }
+
+        if (pagingScheduler)
+        {
+            TRACE_SCOPE("paging");
+            const size_t numPrefetched = pagingScheduler->numPrefetched;
+            auto frameStamp = viewer->getFrameStamp();
+            pagingScheduler->update(pagedObjects, *databasePager, lookAt->eye, frameStamp->simulationTime, frameStamp->frameCount);
+            record.prefetched = static_cast<uint32_t>(pagingScheduler->numPrefetched - numPrefetched);
+        }
+
+        if (residencyManager)
+        {
+            TRACE_SCOPE("residency");
+            residencyManager->update(pagedObjects, lookAt->eye, viewer->getFrameStamp()->frameCount);
+        }
+
+        {
+            TRACE_SCOPE("memory stats");
+            memoryStats->update(pagedObjects);
+        }
+
+        record.housekeeping = milliseconds(timePoint);
+        {
+            TRACE_SCOPE("present");
+            viewer->present();
+        }
+        record.present = milliseconds(timePoint);
 
-        auto duration = std::chrono::duration<double, std::chrono::seconds::period>(vsg::clock::now() - startTime).count();
-        sunLight->direction.set(cos(duration), -1.0, sin(duration));
+        if (databasePager)
+        {
+            record.activeRequests = databasePager->numActiveRequests.load();
+        }
 
-        viewer->recordAndSubmit();
-        viewer->present();
+        record.total = milliseconds(frameStart);
+        frameStats.add(record);
+
+        if (lodController)
+        {
+            lodController->update(record.total, record.activeRequests, pagedObjects, view->viewDependentState);
+        }
+
+        if (memoryReportHandler->requested)
+        {
+            printMemoryReport();
+            memoryReportHandler->requested = false;
+            milliseconds(frameStart);
+        }
 
         numFramesCompleted += 1.0;
     }
@@ -60,16 +293,106 @@ void Application::update()
     if (numFramesCompleted > 0.0)
     {
         std::cout << "Average frame rate = " << (numFramesCompleted / duration) << std::endl;
+        frameStats.print(std::cout);
+    }
+
+    if (numFramesCompleted > 0.0 && recordComparison)
+    {
+        // one line per run, for comparing record times across --record-threads values
+        const FrameStats::Summary record = frameStats.summary(&FrameRecord::recordAndSubmit);
+        std::cout << "Record threads " << recordThreads << ": recordAndSubmit p50 " << record.p50 << " ms, p95 " << record.p95 << " ms" << std::endl;
+    }
+
+    if (frustumCuller && numCulledFrames > 0.0)
+    {
+        std::cout << "Frustum cull (" << (frustumCuller->useAvx2 ? "avx2" : "scalar") << "): " << (numVisibleSum / numCulledFrames)
+                  << " of " << frustumCuller->size() << " placements visible, " << (numCasterSum / numCulledFrames) << " kept as shadow casters on average" << std::endl;
+    }
+    if (occlusionCuller && numTestedSum > 0.0)
+    {
+        std::cout << "Occlusion: " << (100.0 * numOccludedSum / numTestedSum) << "% of the tested placements culled, "
+                  << (numOccludedSum / numCulledFrames) << " per frame" << std::endl;
+    }
+
+    if (captureFile && !offscreenTarget->writeCapture(captureFile))
+    {
+        std::cerr << "Failed to write " << captureFile << '\n';
+    }
+
+    if (benchmark)
+    {
+        std::cout << "Benchmark: " << cameraPath->keys.size() << " path keys, " << cameraPath->duration() << " s simulated at "
+                  << (1.0 / timeStep) << " Hz" << std::endl;
+    }
+
+    if (recordedPath && !recordedPath->write(recordFile))
+    {
+        std::cerr << "Failed to write " << recordFile << '\n';
+    }
+
+    if (frameStatsFile && !frameStats.write(frameStatsFile))
+    {
+        std::cerr << "Failed to write " << frameStatsFile << '\n';
+    }
+
+    if (pagingScheduler)
+    {
+        std::cout << "Paging: " << pagingScheduler->numPrefetched << " prefetched, " << pagingScheduler->numAbandoned << " abandoned to the pager" << std::endl;
+    }
+
+    if (lodController)
+    {
+        std::cout << "LOD: quality scale " << lodController->scale << ", " << lodController->numDecreases << " decreases, "
+                  << lodController->numIncreases << " increases" << std::endl;
+    }
+
+    if (residencyManager)
+    {
+        std::cout << "Residency: " << residencyManager->numResident << " resident, "
+                  << (residencyManager->residentCpuBytes >> 20) << " MiB CPU, " << (residencyManager->residentGpuBytes >> 20) << " MiB GPU, "
+                  << residencyManager->numEvicted << " evicted" << std::endl;
+    }
+
+    if (textureReport)
+    {
+        reader->textureCache->report(std::cout);
+    }
+
+    if (memoryReport)
+    {
+        printMemoryReport();
     }
 }
 
+void Application::printMemoryReport()
+{
+    // with threaded recording the placements hang off the record groups instead of the scene graph
+    auto root = vsg::Group::create();
+    root->addChild(sceneGraph);
+    for (auto& recordGroup : recordGroups)
+    {
+        root->addChild(recordGroup);
+    }
+
+    memoryStats->print(std::cout, memoryStats->collect(pagedObjects, root));
+}
+
 void Application::initializeOptions()
 {
     options = vsg::Options::create();
     // options->add(vsgXchange::all::create());
-    options->add(DMD_Reader::create());
-    DMD_Reader::init();
+    reader = DMD_Reader::create();
+    reader->textureCache->maxDimension = arguments.value<uint32_t>(0, "--texture-max-size");
+    reader->textureCache->budget = arguments.value<size_t>(0, "--texture-budget") * 1024 * 1024;
+    reader->decodePool = TextureDecodePool::create(reader->textureCache, arguments.value<uint32_t>(0, "--decode-threads"));
+    options->add(reader);
     options->sharedObjects = vsg::SharedObjects::create();
+
+    memoryStats = MemoryStats::create();
+    reader->memoryStats = memoryStats;
+
+    fileIndex = FileIndex::create();
+    options->findFileCallback = fileIndex->findFileCallback();
 }
 
 void Application::createShaderSet()
@@ -90,16 +413,130 @@ void Application::createShaderSet()
     phong->variants.clear();
 
     options->shaderSets["phong"] = phong;
+
+    reader->init(phong);
+
+    const vsg::Path shaderCacheDirectory = arguments.value<vsg::Path>("shader_cache", "--shader-cache");
+    if (!arguments.read("--no-shader-cache"))
+    {
+        auto shaderCache = ShaderCache::create(shaderCacheDirectory);
+        shaderCache->apply(reader->shaderStages(), options);
+        std::cout << "Shader cache: " << shaderCache->hits << " hits, " << shaderCache->misses << " compiled" << std::endl;
+    }
 }
 
 void Application::initializeSceneGraph()
 {
-    const std::string route_path = "../routes/rostov-kavkazskaya";
+    const std::string route_path = arguments.value<std::string>("../routes/rostov-kavkazskaya", "--route");
 
     sceneGraph = vsg::Group::create();
 
-    loadObjectsRef(route_path);
-    loadRouteMap(route_path);
+    loadRoute(route_path);
+
+    vsg::dvec3 preloadCenter(0.0, 0.0, 0.0);
+    if (benchmark)
+    {
+        startupTimer.measure("camera path", [&]() { createCameraPath(); });
+        preloadCenter = cameraPath->keys.front().eye;
+    }
+
+    if (arguments.read("--atlas"))
+    {
+        startupTimer.measure("texture atlas", [&]() { createTextureAtlas(); });
+    }
+
+    startupTimer.measure("texture preload", [&]() {
+        preloadTextures(preloadCenter, arguments.value<double>(500.0, "--preload-radius"));
+    });
+}
+
+void Application::preloadTextures(const vsg::dvec3& center, double radius)
+{
+    std::vector<std::pair<double, uint32_t>> nearby;
+    for (const ObjectTransformation& transformation : route->objectTransformations)
+    {
+        const double distance = vsg::length(transformation.translation - center);
+        if (distance <= radius)
+        {
+            nearby.emplace_back(distance, route->objectsRef[transformation.referenceId].textureId);
+        }
+    }
+
+    // closest first, the pool deduplicates repeated textures
+    std::sort(nearby.begin(), nearby.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    for (const auto& [distance, textureId] : nearby)
+    {
+        const vsg::Path& texturePath = reader->assets->texturePath(textureId);
+        if (reader->textureAtlas && reader->textureAtlas->find(texturePath))
+        {
+            continue;
+        }
+
+        // DMD_Reader::read acquires the resolved path, the pool has to see the same key
+        if (const vsg::Path textureFile = vsg::findFile(texturePath, options))
+        {
+            reader->decodePool->request(textureId, textureFile);
+        }
+    }
+}
+
+void Application::createCameraPath()
+{
+    vsg::Path pathFile;
+    if (arguments.read("--camera-path", pathFile))
+    {
+        cameraPath = CameraPath::read(pathFile);
+        if (!cameraPath)
+        {
+            throw std::runtime_error("Failed to read camera path " + pathFile.string());
+        }
+        return;
+    }
+
+    // without a recorded path, drive through the placements at a fixed speed
+    std::vector<vsg::dvec3> placements;
+    placements.reserve(route->objectTransformations.size());
+    for (const ObjectTransformation& transformation : route->objectTransformations)
+    {
+        placements.push_back(transformation.translation);
+    }
+
+    const double speed = arguments.value<double>(160.0, "--speed") / 3.6;
+    cameraPath = CameraPath::follow(placements, speed, arguments.value<double>(5.0, "--eye-height"));
+    if (!cameraPath)
+    {
+        throw std::runtime_error("Failed to generate a camera path, the route has no placements");
+    }
+    if (cameraPath->numGaps > 0)
+    {
+        std::cout << "Camera path bridges " << cameraPath->numGaps << " gaps in the route, the longest " << cameraPath->longestGap << " m" << std::endl;
+    }
+}
+
+void Application::createTextureAtlas()
+{
+    auto textureAtlas = TextureAtlas::create();
+    textureAtlas->maxTextureSize = arguments.value<uint32_t>(64, "--atlas-max-size");
+    textureAtlas->pageSize = arguments.value<uint32_t>(1024, "--atlas-page-size");
+
+    std::vector<vsg::Path> texturePaths;
+    for (uint32_t textureId = 0; textureId < reader->assets->numTextures(); ++textureId)
+    {
+        texturePaths.push_back(reader->assets->texturePath(textureId));
+    }
+
+    textureAtlas->build(texturePaths);
+
+    vsg::Path indexFile;
+    if (arguments.read("--atlas-index", indexFile) && !textureAtlas->writeIndex(indexFile))
+    {
+        std::cerr << "Failed to write atlas index " << indexFile << '\n';
+    }
+
+    std::cout << "Packed " << textureAtlas->numTextures() << " textures into " << textureAtlas->numPages() << " atlas pages" << std::endl;
+
+    reader->set_texture_atlas(textureAtlas);
 }
 
 void Application::createLights()
@@ -134,117 +571,62 @@ void Application::createView()
     view->viewDependentState->shadowMapBias = shadowMapBias;
     view->viewDependentState->lambda = lambda;
     view->addChild(sceneGraph);
+
+    // the secondary command graphs record inside the primary render pass, where no shadow map can be rendered, so
+    // runs comparing thread counts go without shadow maps at every count, 0 included
+    if (recordComparison)
+    {
+        view->features = vsg::RECORD_LIGHTS;
+        std::cout << "--record-threads renders without shadow maps, at every thread count" << std::endl;
+    }
 }
 
-void Application::loadObjectsRef(const std::string& routePath)
+void Application::loadRoute(const std::string& routePath)
 {
-    std::set<std::string> invalidTextures;
-    bool mipmap = false;
-    bool smooth = false;
-
-    std::ifstream file(routePath + "/objects.ref");
-    std::string line;
+    // the reader resolves every model and texture of the route against this snapshot
+    if (!fileIndex->add(routePath))
+    {
+        std::cerr << "Failed to list route directory " << routePath << '\n';
+    }
 
-    while (std::getline(file, line))
+    route = Route::create(reader->assets);
+    route->minimumScreenHeightRatio = arguments.value<double>(0.2, "--lod-ratio");
+    if (!startupTimer.measure("route parse", [&]() { return route->loadObjectsRef(routePath); }))
     {
-        if (line.empty() || line[0] == ';' || line[0] == ':')
-        {
-            continue;
-        }
-        else if (line == "[mipmap]")
-        {
-            mipmap = true;
-        }
-        else if (line == "[not_mipmap]")
-        {
-            mipmap = false;
-        }
-        else if (line == "[smooth]")
-        {
-            smooth = true;
-        }
-        else if (line == "[not_smooth]")
-        {
-            smooth = false;
-        }
-        else
-        {
-            std::istringstream stream(line);
-            std::string label, modelPath, texturePath;
-            stream >> label >> modelPath >> texturePath;
-
-            modelPath = routePath + modelPath;
-            texturePath = routePath + texturePath;
-
-            ObjectRef objectRef;
-            objectRef.label = label;
-            objectRef.modelPath = modelPath;
-            objectRef.texturePath = texturePath;
-            objectRef.mipmap = mipmap;
-            objectRef.smooth = smooth;
-            objectsRef.push_back(objectRef);
-        }
+        std::cerr << "Failed to read " << routePath << "/objects.ref" << '\n';
+    }
+    if (!startupTimer.measure("ref resolution", [&]() { return route->loadRouteMap(routePath); }))
+    {
+        std::cerr << "Failed to read " << routePath << "/route1.map" << '\n';
     }
 }
 
-void Application::loadRouteMap(const std::string& routePath)
+void Application::initializeWindow()
 {
-    std::ifstream file(routePath + "/route1.map");
-    std::string line;
+    extent.width = arguments.value<uint32_t>(extent.width, "--width");
+    extent.height = arguments.value<uint32_t>(extent.height, "--height");
 
-    while (std::getline(file, line))
+    vsg::ref_ptr<vsg::Device> device;
+    if (headless)
     {
-        while (true)
-        {
-            auto CR_pos = line.find('\r');
-            if (CR_pos == std::string::npos)
-            {
-                break;
-            }
-            line.erase(CR_pos);
-        }
-
-        if (line.empty() || line.back() != ';' || line[0] == ',')
-        {
-            continue;
-        }
-        else
-        {
-            line.pop_back();
-            std::replace(line.begin(), line.end(), ',', ' ');
-
-            std::istringstream stream(line);
-            std::string label;
-            vsg::dvec3 translation, rotation;
-            stream >> label >> translation >> rotation;
-
-            rotation.x = vsg::radians(rotation.x);
-            rotation.y = vsg::radians(rotation.y);
-            rotation.z = vsg::radians(rotation.z);
-
-            ObjectTransformation objectTransformation;
-            objectTransformation.reference = nullptr;
-            objectTransformation.translation = translation;
-            objectTransformation.rotation = rotation;
-
-            for (ObjectRef& ref : objectsRef)
-            {
-                if (ref.label == label)
-                {
-                    objectTransformation.reference = &ref;
-                    break;
-                }
-            }
+        offscreenTarget = OffscreenTarget::create(extent, arguments.read("--debug-layer"));
+        device = offscreenTarget->device;
+    }
+    else
+    {
+        window = createWindow();
+        device = window->getOrCreateDevice();
+        extent = window->extent2D();
+    }
 
-            if (objectTransformation.reference != nullptr)
-            {
-                objectTransformations.push_back(objectTransformation);
-            }
-        }
+    if (!arguments.read("--no-pipeline-cache"))
+    {
+        pipelineCache = PipelineCache::create(device, arguments.value<vsg::Path>("pipeline_cache.bin", "--pipeline-cache"));
+        device->setObject(PipelineCache::key, pipelineCache);
     }
 }
 
-void Application::initializeWindow()
+vsg::ref_ptr<vsg::Window> Application::createWindow()
 {
     auto windowTraits = vsg::WindowTraits::create();
     // windowTraits->debugLayer = true;
@@ -252,20 +634,23 @@ void Application::initializeWindow()
     // windowTraits->queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
     // windowTraits->vulkanVersion = VK_API_VERSION_1_3;
 
+    windowTraits->width = extent.width;
+    windowTraits->height = extent.height;
+
     auto deviceFeatures = windowTraits->deviceFeatures = vsg::DeviceFeatures::create();
     deviceFeatures->get().samplerAnisotropy = VK_TRUE;
 
-    window = vsg::Window::create(windowTraits);
+    auto window = vsg::Window::create(windowTraits);
     if (!window)
     {
-        throw std::runtime_error("Failed to create window!");
+        throw std::runtime_error("Failed to create window, use --headless to render offscreen!");
     }
+
+    return window;
 }
 
 void Application::initializeCamera()
 {
-    const VkExtent2D& extent = window->extent2D();
-
     constexpr double FOV = 60.0;
     const double aspectRatio = static_cast<double>(extent.width) / static_cast<double>(extent.height);
     constexpr double nearFarRatio = 0.001;
@@ -285,45 +670,294 @@ void Application::initializeCamera()
 
 void Application::initializeCommandGraph()
 {
-    auto renderGraph = vsg::RenderGraph::create(window, view);
+    if (offscreenTarget)
+    {
+        commandGraph = vsg::CommandGraph::create(offscreenTarget->device, offscreenTarget->queueFamily);
+        commandGraph->addChild(offscreenTarget->createRenderGraph(view));
+        if (captureFile)
+        {
+            commandGraph->addChild(offscreenTarget->createCaptureCommands());
+        }
+        return;
+    }
+
+    if (recordThreads == 0)
+    {
+        auto renderGraph = vsg::RenderGraph::create(window, view);
+        commandGraph = vsg::CommandGraph::create(window, renderGraph);
+        return;
+    }
+
+    // every secondary command graph has its own view of the shared camera with the lights and its share of the tiles,
+    // shadow maps can't be rendered inside the primary render pass so those views only record the lights
+    auto executeCommands = vsg::ExecuteCommands::create();
+    for (uint32_t i = 0; i < recordThreads; ++i)
+    {
+        auto recordGroup = vsg::Group::create();
+
+        auto tileView = vsg::View::create(camera);
+        tileView->features = vsg::RECORD_LIGHTS;
+        tileView->addChild(sceneGraph);
+        tileView->addChild(recordGroup);
+
+        auto secondaryCommandGraph = vsg::SecondaryCommandGraph::create(window);
+        secondaryCommandGraph->addChild(tileView);
+        executeCommands->connect(secondaryCommandGraph);
+
+        recordGroups.push_back(recordGroup);
+        secondaryCommandGraphs.push_back(secondaryCommandGraph);
+    }
+
+    auto renderGraph = vsg::RenderGraph::create(window);
+    renderGraph->contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+    renderGraph->addChild(executeCommands);
     commandGraph = vsg::CommandGraph::create(window, renderGraph);
 }
 
-void Application::initializeViewer()
+void Application::createPagedObjects()
+{
+    if (!recordGroups.empty())
+    {
+        auto placements = vsg::Group::create();
+        route->createPagedObjects(options, *placements, pagedObjects);
+        distributeTiles(*placements);
+    }
+    else if (simdCull)
+    {
+        auto placements = vsg::Group::create();
+        route->createPagedObjects(options, *placements, pagedObjects);
+
+        placementSwitch = vsg::Switch::create();
+        placementSwitch->children.reserve(placements->children.size());
+        for (auto& child : placements->children)
+        {
+            placementSwitch->addChild(true, child);
+        }
+        sceneGraph->addChild(placementSwitch);
+
+        std::vector<vsg::dsphere> bounds;
+        bounds.reserve(pagedObjects.size());
+        for (const PagedObject& object : pagedObjects)
+        {
+            bounds.emplace_back(object.center, object.radius);
+        }
+        frustumCuller = FrustumCuller::create();
+        frustumCuller->build(bounds);
+
+        if (occlusion)
+        {
+            occlusionCuller = OcclusionCuller::create(arguments.value<uint32_t>(256, "--occlusion-width"), arguments.value<uint32_t>(128, "--occlusion-height"));
+            occlusionCuller->occluderDistance = arguments.value<double>(1000.0, "--occluder-distance");
+            occlusionCuller->maxOccluders = arguments.value<size_t>(128, "--max-occluders");
+
+            const double occluderRadius = arguments.value<double>(0.0, "--occluder-radius");
+            const size_t occluderTriangles = arguments.value<size_t>(64, "--occluder-triangles");
+            occluders = startupTimer.measure("occluders", [&]() { return OcclusionCuller::createOccluders(*route, options, occluderRadius, occluderTriangles); });
+            std::cout << "Occlusion: " << occluders.size() << " occluders" << std::endl;
+        }
+    }
+    else
+    {
+        route->createPagedObjects(options, *sceneGraph, pagedObjects);
+    }
+
+    // placements of models that haven't loaded yet get their real bounds in refreshPlacementBounds()
+    vsg::box bounds;
+    for (size_t i = 0; i < pagedObjects.size(); ++i)
+    {
+        const uint32_t modelId = pagedObjects[i].modelId;
+        if (!reader->assets->modelBounds(modelId, bounds))
+        {
+            if (modelId >= modelPlacements.size())
+            {
+                modelPlacements.resize(modelId + 1);
+            }
+            if (modelPlacements[modelId].empty())
+            {
+                pendingModels.push_back(modelId);
+            }
+            modelPlacements[modelId].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // placements live on in the scene graph and pagedObjects
+    route->clear();
+}
+
+void Application::distributeTiles(const vsg::Group& placements)
+{
+    struct Tile
+    {
+        vsg::ref_ptr<vsg::CullGroup> group = vsg::CullGroup::create();
+        vsg::dbox bounds;
+    };
+
+    // createPagedObjects() adds one transform per paged object, in the same order
+    std::map<std::pair<int64_t, int64_t>, Tile> tiles;
+    placementTiles.reserve(pagedObjects.size());
+    for (size_t i = 0; i < pagedObjects.size(); ++i)
+    {
+        const PagedObject& object = pagedObjects[i];
+        Tile& tile = tiles[{static_cast<int64_t>(std::floor(object.center.x / tileSize)), static_cast<int64_t>(std::floor(object.center.y / tileSize))}];
+        tile.group->addChild(placements.children[i]);
+        placementTiles.push_back(tile.group);
+        tile.bounds.add(object.center - vsg::dvec3(object.radius, object.radius, object.radius));
+        tile.bounds.add(object.center + vsg::dvec3(object.radius, object.radius, object.radius));
+    }
+
+    // neighbouring tiles go to different threads, so the detailed tiles around the camera are shared out
+    size_t index = 0;
+    for (auto& [key, tile] : tiles)
+    {
+        const vsg::dvec3 center = (tile.bounds.min + tile.bounds.max) * 0.5;
+        tile.group->bound.set(center, vsg::length(tile.bounds.max - center));
+        recordGroups[index++ % recordGroups.size()]->addChild(tile.group);
+    }
+
+    std::cout << "Recording " << tiles.size() << " tiles on " << recordGroups.size() << " threads" << std::endl;
+}
+
+void Application::cullPlacements()
 {
-    for (const ObjectTransformation& transformation : objectTransformations)
+    const vsg::dmat4 projectionView = camera->projectionMatrix->transform() * camera->viewMatrix->transform();
+    const FrustumCuller::Planes planes = FrustumCuller::frustumPlanes(projectionView);
+    numVisibleSum += frustumCuller->cull(planes, cullMargin);
+    numCulledFrames += 1.0;
+
+    // the shadow maps are recorded from the same switch, so whatever can cast a shadow into the view stays on
+    const double shadowDistance = view->viewDependentState->maxShadowDistance;
+    const bool shadows = sunLight->shadowSettings && shadowDistance > 0.0;
+    if (shadows)
+    {
+        frustumCuller->cull(FrustumCuller::shadowCasterPlanes(planes, lookAt->eye, shadowDistance, sunLight->direction), casterBits, cullMargin);
+    }
+
+    if (occlusionCuller)
     {
-        const vsg::Path paths = transformation.reference->modelPath + " " + transformation.reference->texturePath + " qqqqqq.qqqqqq";
+        occlusionCuller->render(occluders, projectionView, lookAt->eye);
+    }
 
-        auto pagedLod = vsg::PagedLOD::create();
-        pagedLod->options = options;
-        pagedLod->filename = paths;
-        pagedLod->children[0].minimumScreenHeightRatio = 0.2;
-        pagedLod->bound = vsg::dsphere(vsg::dvec3(0.0, 0.0, 0.0), 100);
+    // hidden placements are skipped by the record traversal without visiting their transform or PagedLOD
+    const std::vector<uint64_t>& bits = frustumCuller->bits();
+    auto& children = placementSwitch->children;
+    size_t numCasters = 0;
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        const uint64_t bit = uint64_t(1) << (i & 63);
+        const bool inView = (bits[i >> 6] & bit) != 0;
+        const bool caster = shadows && (casterBits[i >> 6] & bit) != 0;
+
+        // an occluded placement can still shadow what is in view
+        const bool visible = caster || (inView && !(occlusionCuller && occlusionCuller->occluded(vsg::dsphere(pagedObjects[i].center, pagedObjects[i].radius))));
+        children[i].mask = visible ? vsg::MASK_ALL : vsg::MASK_OFF;
+        numCasters += (caster && !inView) ? 1 : 0;
+    }
+    numCasterSum += static_cast<double>(numCasters);
+
+    if (occlusionCuller)
+    {
+        numTestedSum += occlusionCuller->numTested;
+        numOccludedSum += occlusionCuller->numOccluded;
+    }
+}
 
-        const vsg::dvec3& translation = transformation.translation;
-        const vsg::dvec3& rotation = transformation.rotation;
+void Application::refreshPlacementBounds()
+{
+    for (size_t i = 0; i < pendingModels.size();)
+    {
+        const uint32_t modelId = pendingModels[i];
+        vsg::box bounds;
+        if (!reader->assets->modelBounds(modelId, bounds))
+        {
+            ++i;
+            continue;
+        }
 
-        vsg::dmat4 m1 = vsg::translate(translation);
-        vsg::dmat4 m2 = vsg::rotate(-rotation.z, vsg::dvec3(0.0f, 0.0f, 1.0f));
-        vsg::dmat4 m3 = vsg::rotate(-rotation.x, vsg::dvec3(1.0f, 0.0f, 0.0f));
-        vsg::dmat4 m4 = vsg::rotate(-rotation.y, vsg::dvec3(0.0f, 1.0f, 0.0f));
+        // the PagedLOD bound is in model space below the placement's transform
+        const vsg::dsphere modelBound = Route::modelSphere(bounds);
+        for (uint32_t index : modelPlacements[modelId])
+        {
+            PagedObject& object = pagedObjects[index];
+            object.pagedLod->bound = modelBound;
+            object.center = object.transform->matrix * modelBound.center;
+            object.radius = modelBound.radius;
 
-        auto matrixTransform = vsg::MatrixTransform::create();
-        matrixTransform->matrix = m1 * m2 * m3 * m4;
-        matrixTransform->addChild(pagedLod);
+            if (frustumCuller)
+            {
+                frustumCuller->set(index, vsg::dsphere(object.center, object.radius));
+            }
 
-        sceneGraph->addChild(matrixTransform);
+            if (!placementTiles.empty())
+            {
+                // grow the tile around the real bounds, keeping its centre
+                vsg::dsphere& tileBound = placementTiles[index]->bound;
+                tileBound.radius = std::max(tileBound.radius, vsg::length(object.center - tileBound.center) + object.radius);
+            }
+        }
+
+        modelPlacements[modelId] = {};
+        pendingModels[i] = pendingModels.back();
+        pendingModels.pop_back();
     }
+}
 
-    objectTransformations.clear();
-    objectsRef.clear();
+void Application::initializeViewer()
+{
+    startupTimer.measure("paged graph", [&]() { createPagedObjects(); });
 
     viewer = vsg::Viewer::create();
-    viewer->addWindow(window);
-    viewer->assignRecordAndSubmitTaskAndPresentation({commandGraph});
+    if (window)
+    {
+        viewer->addWindow(window);
+    }
+    // secondary command graphs first, the primary waits for what they record
+    vsg::CommandGraphs commandGraphs(secondaryCommandGraphs.begin(), secondaryCommandGraphs.end());
+    commandGraphs.push_back(commandGraph);
+    viewer->assignRecordAndSubmitTaskAndPresentation(commandGraphs);
     viewer->addEventHandler(vsg::CloseHandler::create(viewer));
-    viewer->addEventHandler(vsg::Trackball::create(camera));
 
-    viewer->compile();
+    memoryReportHandler = MemoryReportHandler::create();
+    viewer->addEventHandler(memoryReportHandler);
+    if (!benchmark)
+    {
+        viewer->addEventHandler(vsg::Trackball::create(camera));
+    }
+
+    startupTimer.measure("viewer compile", [&]() { viewer->compile(); });
+
+    if (!secondaryCommandGraphs.empty())
+    {
+        viewer->setupThreading();
+    }
+
+    databasePager = viewer->recordAndSubmitTasks.front()->databasePager;
+    if (databasePager && !arguments.read("--no-prefetch"))
+    {
+        pagingScheduler = PagingScheduler::create();
+        pagingScheduler->lookAheadTime = arguments.value<double>(4.0, "--prefetch-time");
+        pagingScheduler->prefetchRadius = arguments.value<double>(250.0, "--prefetch-radius");
+    }
+
+    const size_t cpuBudget = arguments.value<size_t>(0, "--cpu-budget") * 1024 * 1024;
+    const size_t gpuBudget = arguments.value<size_t>(0, "--gpu-budget") * 1024 * 1024;
+    if (cpuBudget > 0 || gpuBudget > 0)
+    {
+        residencyManager = ResidencyManager::create();
+        residencyManager->cpuBudget = cpuBudget;
+        residencyManager->gpuBudget = gpuBudget;
+        residencyManager->sharedObjects = options->sharedObjects;
+        residencyManager->databasePager = databasePager;
+        residencyManager->memoryStats = memoryStats;
+    }
+
+    // scales the LOD ratios and shadow distance to hold the target frame time
+    const double targetFrameTime = arguments.value<double>(0.0, "--target-ms");
+    if (targetFrameTime > 0.0)
+    {
+        lodController = LodController::create();
+        lodController->targetFrameTime = targetFrameTime;
+        lodController->minimumScale = arguments.value<double>(0.25, "--min-lod-scale");
+        lodController->baseRatio = route->minimumScreenHeightRatio;
+        lodController->baseShadowDistance = view->viewDependentState->maxShadowDistance;
+    }
 }
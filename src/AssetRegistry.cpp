@@ -0,0 +1,112 @@
+#include "AssetRegistry.h"
+
+#include <utility>
+
+uint32_t AssetRegistry::intern(const vsg::Path& path, std::vector<AssetInfo>& assets, std::unordered_map<std::string, uint32_t>& ids)
+{
+    auto [itr, inserted] = ids.emplace(path.string(), static_cast<uint32_t>(assets.size()));
+    if (inserted)
+    {
+        assets.emplace_back().path = path;
+    }
+    return itr->second;
+}
+
+uint32_t AssetRegistry::internModel(const vsg::Path& path)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return intern(path, models, modelIds);
+}
+
+uint32_t AssetRegistry::internTexture(const vsg::Path& path)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return intern(path, textures, textureIds);
+}
+
+AssetInfo AssetRegistry::model(uint32_t id) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return models[id];
+}
+
+bool AssetRegistry::modelBounds(uint32_t id, vsg::box& bounds) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    const AssetInfo& info = models[id];
+    if (info.state != LoadState::Loaded)
+    {
+        return false;
+    }
+    bounds = info.bounds;
+    return true;
+}
+
+AssetInfo AssetRegistry::texture(uint32_t id) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return textures[id];
+}
+
+void AssetRegistry::addUse(uint32_t modelId, uint32_t textureId)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    ++models[modelId].useCount;
+    ++textures[textureId].useCount;
+}
+
+void AssetRegistry::modelLoaded(uint32_t id, const vsg::box& bounds, size_t bytes)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    AssetInfo& info = models[id];
+    info.state = LoadState::Loaded;
+    info.bounds = bounds;
+    info.bytes = bytes;
+}
+
+void AssetRegistry::textureLoaded(uint32_t id, size_t bytes)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    AssetInfo& info = textures[id];
+    info.state = LoadState::Loaded;
+    info.bytes = bytes;
+}
+
+bool AssetRegistry::modelFailed(uint32_t id)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return std::exchange(models[id].state, LoadState::Failed) != LoadState::Failed;
+}
+
+bool AssetRegistry::textureFailed(uint32_t id)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return std::exchange(textures[id].state, LoadState::Failed) != LoadState::Failed;
+}
+
+LoadState AssetRegistry::modelState(uint32_t id) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return models[id].state;
+}
+
+LoadState AssetRegistry::textureState(uint32_t id) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return textures[id].state;
+}
+
+int DMD_Request::compare(const vsg::Object& rhs_object) const
+{
+    int result = vsg::Object::compare(rhs_object);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    const auto& rhs = static_cast<const DMD_Request&>(rhs_object);
+    if ((result = vsg::compare_value(modelId, rhs.modelId))) return result;
+    if ((result = vsg::compare_value(textureId, rhs.textureId))) return result;
+    if ((result = vsg::compare_value(mipmap, rhs.mipmap))) return result;
+    return vsg::compare_value(smooth, rhs.smooth);
+}
@@ -0,0 +1,234 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+vsg::ref_ptr<CameraPath> CameraPath::read(const vsg::Path& file)
+{
+    std::ifstream input(file);
+    if (!input)
+    {
+        return {};
+    }
+
+    auto path = CameraPath::create();
+
+    std::string line;
+    while (std::getline(input, line))
+    {
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        Key key;
+        if (stream >> key.time >> key.eye.x >> key.eye.y >> key.eye.z >> key.center.x >> key.center.y >> key.center.z)
+        {
+            path->keys.push_back(key);
+        }
+    }
+
+    return path->keys.empty() ? vsg::ref_ptr<CameraPath>() : path;
+}
+
+bool CameraPath::write(const vsg::Path& file) const
+{
+    std::ofstream output(file);
+    if (!output)
+    {
+        return false;
+    }
+
+    output << "; time eye.x eye.y eye.z center.x center.y center.z\n" << std::setprecision(10);
+    for (const Key& key : keys)
+    {
+        output << key.time << ' ' << key.eye.x << ' ' << key.eye.y << ' ' << key.eye.z << ' '
+               << key.center.x << ' ' << key.center.y << ' ' << key.center.z << '\n';
+    }
+
+    return static_cast<bool>(output);
+}
+
+void CameraPath::add(double time, const vsg::dvec3& eye, const vsg::dvec3& center)
+{
+    keys.push_back(Key{time, eye, center});
+}
+
+// both cell indices in one hash key
+static uint64_t cellKey(int64_t x, int64_t y)
+{
+    return (static_cast<uint64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+vsg::ref_ptr<CameraPath> CameraPath::follow(const std::vector<vsg::dvec3>& placements, double speed, double height, double cellSize)
+{
+    if (placements.empty() || speed <= 0.0)
+    {
+        return {};
+    }
+
+    // average the placements per grid cell to get a sparse, deterministic set of points along the route
+    std::map<std::pair<int64_t, int64_t>, std::pair<vsg::dvec3, size_t>> cells;
+    for (const vsg::dvec3& position : placements)
+    {
+        auto& cell = cells[{static_cast<int64_t>(std::floor(position.x / cellSize)), static_cast<int64_t>(std::floor(position.y / cellSize))}];
+        cell.first += position;
+        ++cell.second;
+    }
+
+    std::vector<vsg::dvec3> points;
+    std::unordered_map<uint64_t, size_t> pointCells;
+    int64_t minX = cells.begin()->first.first, maxX = minX, minY = cells.begin()->first.second, maxY = minY;
+    for (const auto& [index, cell] : cells)
+    {
+        pointCells[cellKey(index.first, index.second)] = points.size();
+        points.push_back(cell.first / static_cast<double>(cell.second));
+        minX = std::min(minX, index.first);
+        maxX = std::max(maxX, index.first);
+        minY = std::min(minY, index.second);
+        maxY = std::max(maxY, index.second);
+    }
+    const int64_t maxRing = std::max(maxX - minX, maxY - minY) + 1;
+
+    auto cellOf = [cellSize](const vsg::dvec3& point) {
+        return std::make_pair(static_cast<int64_t>(std::floor(point.x / cellSize)), static_cast<int64_t>(std::floor(point.y / cellSize)));
+    };
+
+    // nearest unvisited point, looking at rings of cells around the point's cell until no closer one can follow
+    std::vector<bool> visited(points.size(), false);
+    auto nearestUnvisited = [&](const vsg::dvec3& from) {
+        const auto [cx, cy] = cellOf(from);
+        size_t best = points.size();
+        double bestDistance2 = 0.0;
+        for (int64_t ring = 0; ring <= maxRing; ++ring)
+        {
+            const double inner = static_cast<double>(std::max<int64_t>(ring - 1, 0)) * cellSize;
+            if (best < points.size() && inner * inner > bestDistance2)
+            {
+                break;
+            }
+            for (int64_t y = cy - ring; y <= cy + ring; ++y)
+            {
+                // the whole first and last row, only the two ends of the rows between
+                const int64_t step = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+                for (int64_t x = cx - ring; x <= cx + ring; x += step)
+                {
+                    auto itr = pointCells.find(cellKey(x, y));
+                    if (itr == pointCells.end() || visited[itr->second])
+                    {
+                        continue;
+                    }
+                    const double distance2 = vsg::length2(points[itr->second] - from);
+                    if (best == points.size() || distance2 < bestDistance2)
+                    {
+                        best = itr->second;
+                        bestDistance2 = distance2;
+                    }
+                }
+            }
+        }
+        return best;
+    };
+
+    // chain the points from the one nearest the first placement, nearest unvisited neighbour next
+    std::vector<vsg::dvec3> chain;
+    chain.reserve(points.size());
+    std::vector<bool> covered(points.size(), false); // within two cells of the chain
+    const double maxStep2 = (4.0 * cellSize) * (4.0 * cellSize);
+    size_t numGaps = 0;
+    double longestGap = 0.0;
+    size_t current = nearestUnvisited(placements.front());
+    while (current < points.size())
+    {
+        visited[current] = true;
+        chain.push_back(points[current]);
+
+        const auto [cx, cy] = cellOf(points[current]);
+        for (int64_t y = cy - 2; y <= cy + 2; ++y)
+        {
+            for (int64_t x = cx - 2; x <= cx + 2; ++x)
+            {
+                if (auto itr = pointCells.find(cellKey(x, y)); itr != pointCells.end())
+                {
+                    covered[itr->second] = true;
+                }
+            }
+        }
+
+        // points the chain passed close by are dropped rather than flown back to across a gap
+        size_t next = nearestUnvisited(points[current]);
+        while (next < points.size() && covered[next] && vsg::length2(points[next] - points[current]) > maxStep2)
+        {
+            visited[next] = true;
+            next = nearestUnvisited(points[current]);
+        }
+        if (next == points.size())
+        {
+            break;
+        }
+
+        // the camera flies straight across a gap to the nearest part of the route it hasn't driven yet
+        const double step2 = vsg::length2(points[next] - points[current]);
+        if (step2 > maxStep2)
+        {
+            ++numGaps;
+            longestGap = std::max(longestGap, std::sqrt(step2));
+        }
+        current = next;
+    }
+    points.swap(chain);
+
+    auto path = CameraPath::create();
+    path->numGaps = numGaps;
+    path->longestGap = longestGap;
+    const vsg::dvec3 up(0.0, 0.0, height);
+
+    double time = 0.0;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const vsg::dvec3& point = points[i];
+        const vsg::dvec3 ahead = i + 1 < points.size() ? points[i + 1] : point + (point - points[std::max<size_t>(i, 1) - 1]);
+        if (i > 0)
+        {
+            time += vsg::length(point - points[i - 1]) / speed;
+        }
+        path->add(time, point + up, ahead + up);
+    }
+
+    if (path->keys.size() == 1)
+    {
+        path->keys.front().center += vsg::dvec3(1.0, 0.0, 0.0);
+    }
+
+    return path;
+}
+
+void CameraPath::sample(double time, vsg::dvec3& eye, vsg::dvec3& center) const
+{
+    if (keys.empty())
+    {
+        return;
+    }
+
+    auto itr = std::lower_bound(keys.begin(), keys.end(), time, [](const Key& key, double value) { return key.time < value; });
+    if (itr == keys.begin() || itr == keys.end())
+    {
+        const Key& key = itr == keys.end() ? keys.back() : keys.front();
+        eye = key.eye;
+        center = key.center;
+        return;
+    }
+
+    const Key& after = *itr;
+    const Key& before = *(itr - 1);
+    const double span = after.time - before.time;
+    const double r = span > 0.0 ? (time - before.time) / span : 1.0;
+    eye = vsg::mix(before.eye, after.eye, r);
+    center = vsg::mix(before.center, after.center, r);
+}
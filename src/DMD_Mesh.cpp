@@ -0,0 +1,253 @@
+#include "DMD_Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+static bool equal(float a, float b)
+{
+    return std::fabs(a - b) < 0.000001;
+}
+
+static bool read_coordinate(std::istream& input, std::string& buf, float& value)
+{
+    input >> buf;
+    if (!input || buf.find('#') != std::string::npos)
+    {
+        return false;
+    }
+    value = std::stof(buf);
+    return true;
+}
+
+static bool read_indices(std::istream& input, std::vector<uint32_t>& indices, size_t count)
+{
+    for (uint32_t& index : indices)
+    {
+        input >> index;
+        if (!input || index == 0 || index > count)
+        {
+            return false;
+        }
+        --index;
+    }
+    return true;
+}
+
+bool dmd_tokenize(std::istream& inf, DMD_Mesh& mesh)
+{
+    std::string buf;
+    while (inf && buf != "TriMesh()")
+    {
+        inf >> buf;
+    }
+
+    if (!inf)
+    {
+        return false;
+    }
+
+    inf >> buf >> buf;
+
+    std::uint32_t vertex_count, face_count;
+    inf >> vertex_count >> face_count;
+
+    inf >> buf >> buf;
+
+    if (!inf)
+    {
+        return false;
+    }
+
+    mesh.positions.resize(vertex_count);
+    for (vsg::vec3& vertex : mesh.positions)
+    {
+        if (!read_coordinate(inf, buf, vertex.x) || !read_coordinate(inf, buf, vertex.y) || !read_coordinate(inf, buf, vertex.z))
+        {
+            return false;
+        }
+    }
+
+    inf >> buf >> buf >> buf >> buf;
+
+    mesh.position_indices.resize(face_count * 3);
+    if (!read_indices(inf, mesh.position_indices, mesh.positions.size()))
+    {
+        return false;
+    }
+
+    while (inf && buf != "Texture:")
+    {
+        inf >> buf;
+    }
+
+    if (!inf)
+    {
+        return false;
+    }
+
+    inf >> buf >> buf;
+
+    std::uint32_t tex_coord_count;
+    inf >> tex_coord_count >> face_count;
+
+    inf >> buf >> buf;
+
+    if (!inf)
+    {
+        return false;
+    }
+
+    mesh.tex_coords.resize(tex_coord_count);
+    for (vsg::vec2& tex_coord : mesh.tex_coords)
+    {
+        inf >> tex_coord.x >> tex_coord.y >> buf;
+    }
+
+    inf >> buf >> buf >> buf >> buf >> buf;
+
+    mesh.tex_coord_indices.resize(face_count * 3);
+    return read_indices(inf, mesh.tex_coord_indices, mesh.tex_coords.size());
+}
+
+std::vector<DMD_Vertex> dmd_expand_indices(const DMD_Mesh& mesh)
+{
+    const size_t count = std::min(mesh.position_indices.size(), mesh.tex_coord_indices.size());
+
+    std::vector<DMD_Vertex> vertices(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        vertices[i].pos = mesh.positions[mesh.position_indices[i]];
+        vertices[i].tex_coord = mesh.tex_coords[mesh.tex_coord_indices[i]];
+    }
+
+    return vertices;
+}
+
+void dmd_accumulate_normals(std::vector<DMD_Vertex>& vertices)
+{
+    // vertices are not shared yet, every corner gets the normal of its face
+    for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+    {
+        const vsg::vec3& pos_1 = vertices[i].pos;
+        const vsg::vec3& pos_2 = vertices[i + 1].pos;
+        const vsg::vec3& pos_3 = vertices[i + 2].pos;
+
+        vsg::vec3 face_normal = vsg::cross(pos_2 - pos_1, pos_3 - pos_1);
+
+        vertices[i].normal += face_normal;
+        vertices[i + 1].normal += face_normal;
+        vertices[i + 2].normal += face_normal;
+    }
+
+    for (DMD_Vertex& vertex : vertices)
+    {
+        vertex.normal = vsg::normalize(vertex.normal);
+    }
+}
+
+std::vector<uint32_t> dmd_weld(std::vector<DMD_Vertex>& vertices)
+{
+    std::vector<std::uint32_t> indices(vertices.size());
+    for (std::uint32_t i = 0; i < indices.size(); ++i)
+    {
+        indices[i] = i;
+    }
+
+    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        const DMD_Vertex& vertex_1 = vertices[i];
+        for (std::uint32_t j = i + 1; j < vertices.size(); ++j)
+        {
+            const DMD_Vertex& vertex_2 = vertices[j];
+            if (equal(vertex_1.pos.x, vertex_2.pos.x)
+                && equal(vertex_1.pos.y, vertex_2.pos.y)
+                && equal(vertex_1.pos.z, vertex_2.pos.z)
+                && equal(vertex_1.normal.x, vertex_2.normal.x)
+                && equal(vertex_1.normal.y, vertex_2.normal.y)
+                && equal(vertex_1.normal.z, vertex_2.normal.z)
+                && equal(vertex_1.tex_coord.x, vertex_2.tex_coord.x)
+                && equal(vertex_1.tex_coord.y, vertex_2.tex_coord.y))
+            {
+                for (std::uint32_t& index : indices)
+                {
+                    if (index == j)
+                    {
+                        index = i;
+                    }
+                    else if (index > j)
+                    {
+                        --index;
+                    }
+                }
+
+                vertices.erase(vertices.begin() + j);
+
+                --j;
+            }
+        }
+    }
+
+    return indices;
+}
+
+void dmd_remove_degenerates(std::vector<uint32_t>& indices)
+{
+    for (std::uint32_t i = 0; i < indices.size(); i += 3)
+    {
+        std::uint32_t index_1 = indices[i];
+        std::uint32_t index_2 = indices[i + 1];
+        std::uint32_t index_3 = indices[i + 2];
+
+        if (index_1 == index_2 || index_1 == index_3 || index_2 == index_3)
+        {
+            for (std::uint32_t j = 0; j < 3; ++j)
+            {
+                indices.erase(indices.begin() + i);
+            }
+            i -= 3;
+        }
+        else
+        {
+            for (std::uint32_t j = i + 3; j < indices.size(); j += 3)
+            {
+                std::uint32_t index_4 = indices[j];
+                std::uint32_t index_5 = indices[j + 1];
+                std::uint32_t index_6 = indices[j + 2];
+
+                if (index_1 == index_4 && index_2 == index_5 && index_3 == index_6)
+                {
+                    for (std::uint32_t k = 0; k < 3; ++k)
+                    {
+                        indices.erase(indices.begin() + j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+vsg::ref_ptr<ModelData> dmd_pack(const std::vector<DMD_Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    auto model_data = ModelData::create();
+    model_data->vertices = vsg::vec3Array::create(vertices.size());
+    model_data->normals = vsg::vec3Array::create(vertices.size());
+    model_data->tex_coords = vsg::vec2Array::create(vertices.size());
+    model_data->colors = vsg::vec4Array::create(vertices.size());
+    model_data->indices = vsg::ushortArray::create(indices.size());
+
+    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        model_data->vertices->at(i).set(vertices[i].pos.x, vertices[i].pos.y, vertices[i].pos.z);
+        model_data->normals->at(i).set(vertices[i].normal.x, vertices[i].normal.y, vertices[i].normal.z);
+        model_data->tex_coords->at(i).set(vertices[i].tex_coord.x, vertices[i].tex_coord.y);
+        model_data->colors->at(i).set(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    for (std::uint32_t i = 0; i < indices.size(); ++i)
+    {
+        model_data->indices->at(i) = indices.at(i);
+    }
+
+    return model_data;
+}
@@ -1,409 +1,395 @@
 #include "DMD_Reader.h"
 
 #include "Mesh.h"
+#include "Trace.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <set>
 
-#include <stb_image.h>
-
-vsg::ref_ptr<vsg::DescriptorSetLayout>  DMD_Reader::descriptorSetLayout;
-vsg::ref_ptr<vsg::PipelineLayout>       DMD_Reader::pipelineLayout;
-vsg::ref_ptr<vsg::BindGraphicsPipeline> DMD_Reader::bindGraphicsPipeline;
+// tiling texture coordinates can't be remapped into an atlas region
+static bool in_unit_range(const vsg::vec2Array& tex_coords)
+{
+    constexpr float epsilon = 0.001f;
+    for (const vsg::vec2& tex_coord : tex_coords)
+    {
+        if (tex_coord.x < -epsilon || tex_coord.x > 1.0f + epsilon || tex_coord.y < -epsilon || tex_coord.y > 1.0f + epsilon)
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
 vsg::ref_ptr<vsg::Object> DMD_Reader::read(const vsg::Path& filename, vsg::ref_ptr<const vsg::Options> options) const
 {
-    vsg::ref_ptr<vsg::SharedObjects> sharedObjects = options->sharedObjects;
+    // reads come from the DatabasePager threads
+    if (Trace::enabled())
+    {
+        Trace::nameThread("pager");
+    }
+    TRACE_SCOPE("DMD_Reader::read");
 
-    const size_t dot_dmd_pos = filename.find(".dmd");
-    if (dot_dmd_pos == filename.npos)
+    if (vsg::fileExtension(filename) != ".dmd" || !pipeline_variants[0].config)
     {
-        return vsg::StateGroup::create();
+        return {};
     }
 
-    vsg::Path model_path;
-    vsg::Path texture_path;
+    // the loaded arrays, commands and subgraphs are shared through the options' SharedObjects
+    if (!options || !options->sharedObjects)
+    {
+        return {};
+    }
+    vsg::ref_ptr<vsg::SharedObjects> sharedObjects = options->sharedObjects;
 
-    std::stringstream stream(filename);
-    stream >> model_path;
-    stream >> texture_path;
+    // PagedLOD requests carry a DMD_Request in their options, plain reads load the model without texture
+    const DMD_Request* request = options->getObject<DMD_Request>(DMD_Request::key);
 
-    vsg::ref_ptr<ModelData> model_data;
-    const vsg::Path model_file = vsg::findFile(model_path, options);
-    if (!model_file || (vsg::fileExtension(model_file) != ".dmd"))
+    const vsg::Path& model_path = request ? assets->modelPath(request->modelId) : filename;
+    const vsg::Path texture_path = request ? assets->texturePath(request->textureId) : vsg::Path();
+    const bool mipmap = request ? request->mipmap : true;
+
+    // models and textures that failed once are not probed or decoded again
+    if (request && assets->modelState(request->modelId) == LoadState::Failed)
     {
         return vsg::StateGroup::create();
     }
 
-    model_data = load_model(model_file);
+    vsg::ref_ptr<ModelData> model_data;
+    const vsg::Path model_file = vsg::findFile(model_path, options);
+    if (model_file && vsg::fileExtension(model_file) == ".dmd")
+    {
+        model_data = load_model(model_file);
+    }
 
     if (!model_data)
     {
+        if (!request || assets->modelFailed(request->modelId))
+        {
+            vsg::warn("DMD_Reader: failed to load ", model_path);
+        }
         return vsg::StateGroup::create();
     }
 
     vsg::ref_ptr<vsg::Data> texture_data;
-    stbi_uc* pixels = NULL;
-    const vsg::Path textureFile = vsg::findFile(texture_path, options);
-    if (vsg::fileExtension(textureFile) == ".bmp")
+    const AtlasRegion* atlas_region = textureAtlas ? textureAtlas->find(texture_path) : nullptr;
+    if (atlas_region && in_unit_range(*model_data->tex_coords))
+    {
+        for (vsg::vec2& tex_coord : *model_data->tex_coords)
+        {
+            tex_coord.x = atlas_region->offset.x + tex_coord.x * atlas_region->scale.x;
+            tex_coord.y = atlas_region->offset.y + tex_coord.y * atlas_region->scale.y;
+        }
+        texture_data = textureAtlas->page(atlas_region->page);
+    }
+    else if (request && assets->textureState(request->textureId) != LoadState::Failed)
     {
-        stbi_set_flip_vertically_on_load(1);
+        atlas_region = nullptr;
+        if (const vsg::Path textureFile = vsg::findFile(texture_path, options))
+        {
+            texture_data = decodePool ? decodePool->acquire(request->textureId, textureFile) : textureCache->load(request->textureId, textureFile);
+        }
+
+        if (!texture_data)
+        {
+            if (assets->textureFailed(request->textureId))
+            {
+                vsg::warn("DMD_Reader: failed to load ", texture_path);
+            }
+        }
+        else
+        {
+            assets->textureLoaded(request->textureId, texture_data->dataSize());
+        }
     }
     else
     {
-        stbi_set_flip_vertically_on_load(0);
+        atlas_region = nullptr;
+    }
+
+    // only missing textures get the placeholder, plain model reads stay untextured
+    if (!texture_data && texture_path)
+    {
+        texture_data = textureCache->placeholder;
     }
 
-    int width, height, channels;
-    pixels = stbi_load(textureFile.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
-    texture_data = vsg::ubvec4Array2D::create(width, height, reinterpret_cast<vsg::ubvec4*>(pixels), vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+    const bool textured = texture_data.valid();
+    bool transparent = true;
+    if (textured)
+    {
+        texture_data->getValue("transparent", transparent);
+    }
 
-    auto pipeline = vsg::GraphicsPipelineConfigurator::create(options->shaderSets.at("phong"));
+    const size_t variant_index = pipeline_variant_index(textured, mipmap, transparent);
+    const PipelineVariant& variant = pipeline_variants[variant_index];
 
-    vsg::DataList vertexArrays;
-    pipeline->assignArray(vertexArrays, "vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, model_data->vertices);
-    pipeline->assignArray(vertexArrays, "vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, model_data->normals);
-    pipeline->assignArray(vertexArrays, "vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, model_data->tex_coords);
-    pipeline->assignArray(vertexArrays, "vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, model_data->colors);
+    vsg::DataList vertexArrays{model_data->vertices, model_data->normals, model_data->tex_coords, model_data->colors};
 
     sharedObjects->share(vertexArrays);
     sharedObjects->share(model_data->indices);
 
     auto drawCommands = vsg::Commands::create();
-    drawCommands->addChild(vsg::BindVertexBuffers::create(pipeline->baseAttributeBinding, vertexArrays));
+    drawCommands->addChild(vsg::BindVertexBuffers::create(variant.baseAttributeBinding, vertexArrays));
     drawCommands->addChild(vsg::BindIndexBuffer::create(model_data->indices));
     drawCommands->addChild(vsg::DrawIndexed::create(model_data->indices->size(), 1, 0, 0, 0));
 
     sharedObjects->share(drawCommands->children);
     sharedObjects->share(drawCommands);
 
+    auto stateGroup = vsg::StateGroup::create();
+    stateGroup->add(variant.bindGraphicsPipeline);
+    for (auto& stateCommand : bind_descriptors(variant_index, texture_data, atlas_region != nullptr))
+    {
+        stateGroup->add(stateCommand);
+    }
+    for (auto& stateCommand : variant.viewStateCommands)
+    {
+        stateGroup->add(stateCommand);
+    }
+    stateGroup->addChild(drawCommands);
+
+    // used by the ResidencyManager and MemoryStats to account for the loaded subgraph
+    const size_t index_bytes = model_data->indices->dataSize();
+    size_t vertex_bytes = 0;
+    for (auto& array : vertexArrays)
+    {
+        vertex_bytes += array->dataSize();
+    }
+    const size_t geometry_bytes = vertex_bytes + index_bytes;
+    stateGroup->setValue("cpu_bytes", geometry_bytes);
+    stateGroup->setValue("gpu_bytes", geometry_bytes);
+    stateGroup->setValue("vertex_bytes", vertex_bytes);
+    stateGroup->setValue("index_bytes", index_bytes);
     if (texture_data)
     {
-        auto sampler = vsg::Sampler::create();
-        sampler->maxLod = 10.0f;
-        sharedObjects->share(sampler);
-        pipeline->assignTexture("diffuseMap", texture_data, sampler);
+        stateGroup->setObject("texture", texture_data);
     }
 
-    sharedObjects->share(pipeline, [](auto gpc) { gpc->init(); });
+    if (request)
+    {
+        vsg::box bounds;
+        for (const vsg::vec3& vertex : *model_data->vertices)
+        {
+            bounds.add(vertex);
+        }
+        assets->modelLoaded(request->modelId, bounds, geometry_bytes);
+    }
 
-    auto stateGroup = vsg::StateGroup::create();
-    pipeline->copyTo(stateGroup);
-    stateGroup->addChild(drawCommands);
+    // a model read again while its subgraph is still shared gets the existing one, which is no new memory
+    const vsg::ref_ptr<vsg::StateGroup> created = stateGroup;
     sharedObjects->share(stateGroup);
 
+    if (memoryStats && stateGroup == created)
+    {
+        memoryStats->created(vertex_bytes, index_bytes);
+    }
+
     return stateGroup;
 }
 
-struct vertex_t
-{
-    vsg::vec3 pos;
-    vsg::vec3 normal;
-    vsg::vec2 tex_coord;
-};
-
-static bool equal(float a, float b)
+size_t DMD_Reader::pipeline_variant_index(bool textured, bool mipmap, bool alpha_test)
 {
-    return std::fabs(a - b) < 0.000001;
+    return (textured ? 4 : 0) + (mipmap ? 2 : 0) + (alpha_test ? 1 : 0);
 }
 
-vsg::ref_ptr<ModelData> DMD_Reader::load_model(const vsg::Path& path) const
+vsg::StateCommands DMD_Reader::bind_descriptors(size_t variant_index, vsg::ref_ptr<vsg::Data> texture_data, bool atlas) const
 {
-    std::ifstream inf(path);
-    if (!inf)
+    std::scoped_lock<std::mutex> lock(descriptor_mutex);
+
+    // the cache only observes the commands, so a texture is released with the last subgraph that binds it
+    auto& observed = descriptor_binds[{texture_data.get(), variant_index}];
+    vsg::StateCommands stateCommands;
+    for (auto& command : observed)
     {
-        return {};
+        if (auto stateCommand = command.ref_ptr())
+        {
+            stateCommands.push_back(stateCommand);
+        }
     }
-
-    std::string buf;
-    while (buf != "TriMesh()")
+    if (!observed.empty() && stateCommands.size() == observed.size())
     {
-        inf >> buf;
+        return stateCommands;
     }
+    stateCommands.clear();
 
-    inf >> buf >> buf;
-
-    std::uint32_t temp_vertex_count, temp_face_count;
-    inf >> temp_vertex_count >> temp_face_count;
+    const PipelineVariant& variant = pipeline_variants[variant_index];
 
-    inf >> buf >> buf;
-
-    std::vector<vsg::vec3> temp_vertices(temp_vertex_count);
-    for (vsg::vec3& vertex : temp_vertices)
+    auto descriptors = vsg::DescriptorConfigurator::create(variant.config->shaderSet);
+    if (texture_data)
     {
-        inf >> buf;
-        if (buf.find('#') != std::string::npos)
-        {
-            return {};
-        }
-        vertex.x = std::stof(buf);
+        descriptors->assignTexture("diffuseMap", texture_data, atlas ? variant.atlasSampler : variant.sampler);
+    }
+    descriptors->assignDefaults();
 
-        inf >> buf;
-        if (buf.find('#') != std::string::npos)
+    for (uint32_t set = 0; set < descriptors->descriptorSets.size(); ++set)
+    {
+        if (auto& descriptorSet = descriptors->descriptorSets[set])
         {
-            return {};
+            stateCommands.push_back(vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, variant.config->layout, set, descriptorSet));
         }
-        vertex.y = std::stof(buf);
+    }
+    observed.assign(stateCommands.begin(), stateCommands.end());
 
-        inf >> buf;
-        if (buf.find('#') != std::string::npos)
+    // drop the entries whose commands are all gone once the map has grown
+    if (descriptor_binds.size() >= 2 * descriptor_binds_pruned_size + 64)
+    {
+        for (auto itr = descriptor_binds.begin(); itr != descriptor_binds.end();)
         {
-            return {};
+            const bool unused = std::none_of(itr->second.begin(), itr->second.end(), [](auto& command) { return command.valid(); });
+            if (unused)
+            {
+                itr = descriptor_binds.erase(itr);
+            }
+            else
+            {
+                ++itr;
+            }
         }
-        vertex.z = std::stof(buf);
+        descriptor_binds_pruned_size = descriptor_binds.size();
     }
 
-    inf >> buf >> buf >> buf >> buf;
+    return stateCommands;
+}
 
-    std::vector<std::uint32_t> temp_vertex_indices(temp_face_count * 3);
-    for (std::uint32_t& index : temp_vertex_indices)
-    {
-        inf >> index;
-        --index;
-    }
+vsg::ref_ptr<ModelData> DMD_Reader::load_model(const vsg::Path& path)
+{
+    TRACE_SCOPE("load_model");
 
-    while (buf != "Texture:")
+    std::ifstream inf(path);
+    if (!inf)
     {
-        inf >> buf;
+        return {};
     }
 
-    inf >> buf >> buf;
-
-    std::uint32_t temp_tex_coord_count;
-    inf >> temp_tex_coord_count >> temp_face_count;
-
-    inf >> buf >> buf;
-
-    std::vector<vsg::vec2> temp_tex_coords(temp_tex_coord_count);
-    for (vsg::vec2& tex_coord : temp_tex_coords)
+    DMD_Mesh mesh;
     {
-        inf >> tex_coord.x >> tex_coord.y >> buf;
+        TRACE_SCOPE("dmd tokenize");
+        if (!dmd_tokenize(inf, mesh))
+        {
+            return {};
+        }
     }
 
-    inf >> buf >> buf >> buf >> buf >> buf;
-
-    std::vector<std::uint32_t> temp_tex_coord_indices(temp_face_count * 3);
-    for (std::uint32_t& index : temp_tex_coord_indices)
+    std::vector<DMD_Vertex> vertices;
     {
-        inf >> index;
-        --index;
+        TRACE_SCOPE("dmd expand");
+        vertices = dmd_expand_indices(mesh);
+        mesh = DMD_Mesh();
     }
 
-    std::vector<vertex_t> vertices(temp_face_count * 3);
-    for (std::uint32_t i = 0; i < temp_face_count * 3; ++i)
     {
-        vertices[i].pos = temp_vertices[temp_vertex_indices[i]];
-        vertices[i].tex_coord = temp_tex_coords[temp_tex_coord_indices[i]];
+        TRACE_SCOPE("dmd normals");
+        dmd_accumulate_normals(vertices);
     }
 
-    temp_tex_coord_indices.clear();
-    temp_tex_coords.clear();
-    temp_vertex_indices.clear();
-    temp_vertices.clear();
-
-    std::vector<std::uint32_t> indices(temp_face_count * 3);
-    for (std::uint32_t i = 0; i < temp_face_count * 3; ++i)
+    std::vector<uint32_t> indices;
     {
-        indices[i] = i;
+        TRACE_SCOPE("dmd weld");
+        indices = dmd_weld(vertices);
     }
 
-    for (std::uint32_t i = 0; i < indices.size(); i += 3)
     {
-        std::uint32_t index_1 = indices[i];
-        std::uint32_t index_2 = indices[i + 1];
-        std::uint32_t index_3 = indices[i + 2];
-
-        const vsg::vec3& pos_1 = vertices[index_1].pos;
-        const vsg::vec3& pos_2 = vertices[index_2].pos;
-        const vsg::vec3& pos_3 = vertices[index_3].pos;
-
-        vsg::vec3& normal_1 = vertices[index_1].normal;
-        vsg::vec3& normal_2 = vertices[index_2].normal;
-        vsg::vec3& normal_3 = vertices[index_3].normal;
-
-        vsg::vec3 face_normal = vsg::cross(pos_2 - pos_1, pos_3 - pos_1);
-
-        normal_1 += face_normal;
-        normal_2 += face_normal;
-        normal_3 += face_normal;
+        TRACE_SCOPE("dmd degenerates");
+        dmd_remove_degenerates(indices);
     }
 
-    for (vertex_t& vertex : vertices)
-    {
-        vertex.normal = vsg::normalize(vertex.normal);
-    }
+    TRACE_SCOPE("dmd pack");
+    return dmd_pack(vertices, indices);
+}
 
-    for (std::uint32_t i = 0; i < vertices.size(); ++i)
+void DMD_Reader::remove_carriage_return_symbols(std::string& str) const
+{
+    while (true)
     {
-        const vertex_t& vertex_1 = vertices[i];
-        for (std::uint32_t j = i + 1; j < vertices.size(); ++j)
+        auto CR_pos = str.find('\r');
+        if (CR_pos == std::string::npos)
         {
-            const vertex_t& vertex_2 = vertices[j];
-            if (equal(vertex_1.pos.x, vertex_2.pos.x)
-                && equal(vertex_1.pos.y, vertex_2.pos.y)
-                && equal(vertex_1.pos.z, vertex_2.pos.z)
-                && equal(vertex_1.normal.x, vertex_2.normal.x)
-                && equal(vertex_1.normal.y, vertex_2.normal.y)
-                && equal(vertex_1.normal.z, vertex_2.normal.z)
-                && equal(vertex_1.tex_coord.x, vertex_2.tex_coord.x)
-                && equal(vertex_1.tex_coord.y, vertex_2.tex_coord.y))
-            {
-                for (std::uint32_t& index : indices)
-                {
-                    if (index == j)
-                    {
-                        index = i;
-                    }
-                    else if (index > j)
-                    {
-                        --index;
-                    }
-                }
-
-                vertices.erase(vertices.begin() + j);
-
-                --j;
-            }
+            break;
         }
+        str.erase(CR_pos);
     }
+}
 
-    for (std::uint32_t i = 0; i < indices.size(); i += 3)
+void DMD_Reader::init(vsg::ref_ptr<vsg::ShaderSet> shaderSet)
+{
+    for (size_t index = 0; index < pipeline_variants.size(); ++index)
     {
-        std::uint32_t index_1 = indices[i];
-        std::uint32_t index_2 = indices[i + 1];
-        std::uint32_t index_3 = indices[i + 2];
+        const bool textured = (index & 4) != 0;
+        const bool mipmap = (index & 2) != 0;
+        const bool alpha_test = (index & 1) != 0;
 
-        if (index_1 == index_2 || index_1 == index_3 || index_2 == index_3)
+        auto config = vsg::GraphicsPipelineConfigurator::create(shaderSet);
+        if (!alpha_test && config->shaderHints)
         {
-            for (std::uint32_t j = 0; j < 3; ++j)
-            {
-                indices.erase(indices.begin() + i);
-            }
-            i -= 3;
+            config->shaderHints->defines.erase("VSG_ALPHA_TEST");
         }
-        else
+
+        // same binding order as the vertex arrays assembled in read()
+        config->enableArray("vsg_Vertex", VK_VERTEX_INPUT_RATE_VERTEX, sizeof(vsg::vec3));
+        config->enableArray("vsg_Normal", VK_VERTEX_INPUT_RATE_VERTEX, sizeof(vsg::vec3));
+        config->enableArray("vsg_TexCoord0", VK_VERTEX_INPUT_RATE_VERTEX, sizeof(vsg::vec2));
+        config->enableArray("vsg_Color", VK_VERTEX_INPUT_RATE_VERTEX, sizeof(vsg::vec4));
+        if (textured)
         {
-            for (std::uint32_t j = i + 3; j < indices.size(); j += 3)
+            config->enableTexture("diffuseMap");
+        }
+        config->init();
+
+        auto templateGroup = vsg::StateGroup::create();
+        config->copyTo(templateGroup);
+
+        PipelineVariant& variant = pipeline_variants[index];
+        variant.config = config;
+        variant.baseAttributeBinding = config->baseAttributeBinding;
+        for (auto& stateCommand : templateGroup->stateCommands)
+        {
+            if (auto bindPipeline = stateCommand.cast<vsg::BindGraphicsPipeline>())
+            {
+                // created through the device's PipelineCache when one is attached
+                variant.bindGraphicsPipeline = BindCachedGraphicsPipeline::create(bindPipeline->pipeline);
+            }
+            else if (!stateCommand.cast<vsg::BindDescriptorSet>())
             {
-                std::uint32_t index_4 = indices[j];
-                std::uint32_t index_5 = indices[j + 1];
-                std::uint32_t index_6 = indices[j + 2];
-
-                if (index_1 == index_4 && index_2 == index_5 && index_3 == index_6)
-                {
-                    for (std::uint32_t k = 0; k < 3; ++k)
-                    {
-                        indices.erase(indices.begin() + j);
-                    }
-                }
+                // view dependent descriptor sets are shared by every object
+                variant.viewStateCommands.push_back(stateCommand);
             }
         }
-    }
 
-    auto model_data = ModelData::create();
-    model_data->vertices = vsg::vec3Array::create(vertices.size());
-    model_data->normals = vsg::vec3Array::create(vertices.size());
-    model_data->tex_coords = vsg::vec2Array::create(vertices.size());
-    model_data->colors = vsg::vec4Array::create(vertices.size());
-    model_data->indices = vsg::ushortArray::create(indices.size());
+        variant.sampler = vsg::Sampler::create();
+        variant.sampler->maxLod = mipmap ? 10.0f : 0.0f;
 
-    for (std::uint32_t i = 0; i < vertices.size(); ++i)
-    {
-        model_data->vertices->at(i).set(vertices[i].pos.x, vertices[i].pos.y, vertices[i].pos.z);
-        model_data->normals->at(i).set(vertices[i].normal.x, vertices[i].normal.y, vertices[i].normal.z);
-        model_data->tex_coords->at(i).set(vertices[i].tex_coord.x, vertices[i].tex_coord.y);
-        model_data->colors->at(i).set(1.0f, 1.0f, 1.0f, 1.0f);
-    }
-
-    for (std::uint32_t i = 0; i < indices.size(); ++i)
-    {
-        model_data->indices->at(i) = indices.at(i);
+        variant.atlasSampler = vsg::Sampler::create(*variant.sampler);
+        variant.atlasSampler->addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        variant.atlasSampler->addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        if (textureAtlas)
+        {
+            variant.atlasSampler->maxLod = std::min(variant.sampler->maxLod, textureAtlas->maxLod());
+        }
     }
-
-    return model_data;
 }
 
-void DMD_Reader::remove_carriage_return_symbols(std::string& str) const
+void DMD_Reader::set_texture_atlas(vsg::ref_ptr<TextureAtlas> atlas)
 {
-    while (true)
+    textureAtlas = atlas;
+    for (PipelineVariant& variant : pipeline_variants)
     {
-        auto CR_pos = str.find('\r');
-        if (CR_pos == std::string::npos)
+        if (variant.atlasSampler)
         {
-            break;
+            variant.atlasSampler->maxLod = atlas ? std::min(variant.sampler->maxLod, atlas->maxLod()) : variant.sampler->maxLod;
         }
-        str.erase(CR_pos);
     }
 }
 
-//------------------------------------------------------------------------------
-// layout(location = 0) in vec3 vsg_Vertex;
-// layout(location = 1) in vec3 vsg_Normal;
-// layout(location = 2) in vec2 vsg_TexCoord0;
-// layout(location = 3) in vec4 vsg_Color;
-//------------------------------------------------------------------------------
-// layout(set = MATERIAL_DESCRIPTOR_SET, binding = 10) uniform MaterialData
-// {
-// vec4 ambientColor;
-// vec4 diffuseColor;
-// vec4 specularColor;
-// vec4 emissiveColor;
-// float shininess;
-// float alphaMask;
-// float alphaMaskCutoff;
-// } material;
-//------------------------------------------------------------------------------
-// layout(set = VIEW_DESCRIPTOR_SET, binding = 0) uniform LightData
-// {
-// vec4 values[2048];
-// } lightData;
-//------------------------------------------------------------------------------
-// layout(set = VIEW_DESCRIPTOR_SET, binding = 2) uniform sampler2DArrayShadow shadowMaps;
-//------------------------------------------------------------------------------
-
-void DMD_Reader::init()
+vsg::ShaderStages DMD_Reader::shaderStages() const
 {
-    vsg::Paths searchPaths({"../"});
-    vsg::ref_ptr<vsg::ShaderStage> vertexShader = vsg::ShaderStage::read(VK_SHADER_STAGE_VERTEX_BIT, "main", vsg::findFile("shaders/vert_PushConstants.spv", searchPaths));
-    vsg::ref_ptr<vsg::ShaderStage> fragmentShader = vsg::ShaderStage::read(VK_SHADER_STAGE_FRAGMENT_BIT, "main", vsg::findFile("shaders/frag_PushConstants.spv", searchPaths));
-
-    //!!!
-    vsg::DescriptorSetLayoutBindings descriptorBindings{
-        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr} // { binding, descriptorType, descriptorCount, stageFlags, pImmutableSamplers}
-    };
-    //!!!
-
-    descriptorSetLayout = vsg::DescriptorSetLayout::create(descriptorBindings);
-
-    vsg::PushConstantRanges pushConstantRanges{
-        {VK_SHADER_STAGE_VERTEX_BIT, 0, 128} // projection, view, and model matrices, actual push constant calls automatically provided by the VSG's RecordTraversal
-    };
-
-    vsg::VertexInputState::Bindings vertexBindingsDescriptions{
-        VkVertexInputBindingDescription{0, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // vertex data
-        VkVertexInputBindingDescription{1, sizeof(vsg::vec3), VK_VERTEX_INPUT_RATE_VERTEX}, // normal data
-        VkVertexInputBindingDescription{2, sizeof(vsg::vec2), VK_VERTEX_INPUT_RATE_VERTEX}, // tex coord data
-        VkVertexInputBindingDescription{3, sizeof(vsg::vec4), VK_VERTEX_INPUT_RATE_VERTEX}  // color data
-    };
-
-    vsg::VertexInputState::Attributes vertexAttributeDescriptions{
-        VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},   // vertex data
-        VkVertexInputAttributeDescription{1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0},   // normal data
-        VkVertexInputAttributeDescription{2, 2, VK_FORMAT_R32G32_SFLOAT, 0},      // tex coord data
-        VkVertexInputAttributeDescription{3, 3, VK_FORMAT_R32G32B32A32_SFLOAT, 0} // color data
-    };
-
-    vsg::GraphicsPipelineStates pipelineStates{
-       vsg::VertexInputState::create(vertexBindingsDescriptions, vertexAttributeDescriptions),
-       vsg::InputAssemblyState::create(),
-       vsg::RasterizationState::create(),
-       vsg::MultisampleState::create(),
-       vsg::ColorBlendState::create(),
-       vsg::DepthStencilState::create()
-    };
-
-    pipelineLayout = vsg::PipelineLayout::create(vsg::DescriptorSetLayouts{descriptorSetLayout}, pushConstantRanges);
-    auto graphicsPipeline = vsg::GraphicsPipeline::create(pipelineLayout, vsg::ShaderStages{vertexShader, fragmentShader}, pipelineStates);
-    bindGraphicsPipeline = vsg::BindGraphicsPipeline::create(graphicsPipeline);
+    vsg::ShaderStages stages;
+    for (const PipelineVariant& variant : pipeline_variants)
+    {
+        if (variant.config && variant.config->graphicsPipeline)
+        {
+            const auto& variantStages = variant.config->graphicsPipeline->stages;
+            stages.insert(stages.end(), variantStages.begin(), variantStages.end());
+        }
+    }
+    return stages;
 }
@@ -0,0 +1,117 @@
+#include "DMD_Writer.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+static void write_faces(std::ostream& output, const std::vector<uint32_t>& indices)
+{
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        output << (indices[i] + 1) << ' ' << (indices[i + 1] + 1) << ' ' << (indices[i + 2] + 1) << '\n';
+    }
+}
+
+bool dmd_write(std::ostream& output, const DMD_Mesh& mesh)
+{
+    // enough digits to read back the same floats
+    output << std::setprecision(9);
+
+    output << "New object\nTriMesh()\nnumverts numfaces\n"
+           << mesh.positions.size() << ' ' << mesh.position_indices.size() / 3 << '\n'
+           << "Mesh vertices:\n";
+    for (const vsg::vec3& position : mesh.positions)
+    {
+        output << position.x << ' ' << position.y << ' ' << position.z << '\n';
+    }
+
+    output << "end vertices\nMesh faces:\n";
+    write_faces(output, mesh.position_indices);
+    output << "end faces\nend mesh\n";
+
+    output << "New Texture:\nnumtverts numtvfaces\n"
+           << mesh.tex_coords.size() << ' ' << mesh.tex_coord_indices.size() / 3 << '\n'
+           << "Texture vertices:\n";
+    for (const vsg::vec2& tex_coord : mesh.tex_coords)
+    {
+        output << tex_coord.x << ' ' << tex_coord.y << " 0\n";
+    }
+
+    output << "end texture vertices\nTexture faces:\n";
+    write_faces(output, mesh.tex_coord_indices);
+    output << "end texture faces\nend of texture\nend of file\n";
+
+    return static_cast<bool>(output);
+}
+
+bool dmd_write(const vsg::Path& file, const DMD_Mesh& mesh)
+{
+    std::ofstream output(file);
+    return output && dmd_write(output, mesh);
+}
+
+DMD_Mesh dmd_grid(uint32_t columns, uint32_t rows, float size)
+{
+    DMD_Mesh mesh;
+
+    for (uint32_t r = 0; r <= rows; ++r)
+    {
+        for (uint32_t c = 0; c <= columns; ++c)
+        {
+            const float u = static_cast<float>(c) / static_cast<float>(columns);
+            const float v = static_cast<float>(r) / static_cast<float>(rows);
+            const float height = 0.05f * size * std::sin(u * 3.14159265f) * std::sin(v * 3.14159265f);
+
+            mesh.positions.emplace_back((u - 0.5f) * size, (v - 0.5f) * size, height);
+            mesh.tex_coords.emplace_back(u, 1.0f - v);
+        }
+    }
+
+    for (uint32_t r = 0; r < rows; ++r)
+    {
+        for (uint32_t c = 0; c < columns; ++c)
+        {
+            const uint32_t i00 = r * (columns + 1) + c;
+            const uint32_t i10 = i00 + 1;
+            const uint32_t i01 = i00 + columns + 1;
+            const uint32_t i11 = i01 + 1;
+
+            for (uint32_t index : {i00, i10, i11, i00, i11, i01})
+            {
+                mesh.position_indices.push_back(index);
+                mesh.tex_coord_indices.push_back(index);
+            }
+        }
+    }
+
+    return mesh;
+}
+
+DMD_Mesh dmd_box(float width, float depth, float height)
+{
+    DMD_Mesh mesh;
+
+    const float x = width * 0.5f;
+    const float y = depth * 0.5f;
+    for (float z : {0.0f, height})
+    {
+        mesh.positions.emplace_back(-x, -y, z);
+        mesh.positions.emplace_back(x, -y, z);
+        mesh.positions.emplace_back(x, y, z);
+        mesh.positions.emplace_back(-x, y, z);
+    }
+    mesh.tex_coords = {vsg::vec2(0.0f, 0.0f), vsg::vec2(1.0f, 0.0f), vsg::vec2(1.0f, 1.0f), vsg::vec2(0.0f, 1.0f)};
+
+    // outward facing quads, corners counter clockwise
+    const uint32_t faces[6][4] = {{0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+    for (const auto& face : faces)
+    {
+        for (uint32_t corner : {0u, 1u, 2u, 0u, 2u, 3u})
+        {
+            mesh.position_indices.push_back(face[corner]);
+            mesh.tex_coord_indices.push_back(corner);
+        }
+    }
+
+    return mesh;
+}
@@ -0,0 +1,101 @@
+#include "FileIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+std::string FileIndex::normalize(const vsg::Path& path)
+{
+    // route files are often written on Windows
+    std::string str = path.string();
+    std::replace(str.begin(), str.end(), '\\', '/');
+    return std::filesystem::path(str).lexically_normal().generic_string();
+}
+
+std::string FileIndex::lowercase(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return str;
+}
+
+bool FileIndex::add(const vsg::Path& directory)
+{
+    std::string root = normalize(directory);
+    if (!root.empty() && root.back() != '/')
+    {
+        root.push_back('/');
+    }
+
+    if (std::find(directories.begin(), directories.end(), root) != directories.end())
+    {
+        return true;
+    }
+
+    std::error_code error;
+    std::filesystem::recursive_directory_iterator itr(root, std::filesystem::directory_options::follow_directory_symlink, error);
+    if (error)
+    {
+        return false;
+    }
+
+    for (const std::filesystem::recursive_directory_iterator end; itr != end; itr.increment(error))
+    {
+        if (error)
+        {
+            break;
+        }
+
+        if (itr->is_regular_file(error))
+        {
+            const std::string key = normalize(itr->path().string());
+            const vsg::Path file(itr->path().string());
+            files.emplace(key, file);
+            lowercaseFiles.emplace(lowercase(key), file);
+        }
+    }
+
+    directories.push_back(root);
+    return true;
+}
+
+bool FileIndex::covers(const vsg::Path& path) const
+{
+    const std::string key = normalize(path);
+    return std::any_of(directories.begin(), directories.end(), [&key](const std::string& directory) {
+        return key.compare(0, directory.size(), directory) == 0;
+    });
+}
+
+vsg::Path FileIndex::find(const vsg::Path& path) const
+{
+    const std::string key = normalize(path);
+    if (auto itr = files.find(key); itr != files.end())
+    {
+        return itr->second;
+    }
+
+    // case mismatches between objects.ref and the files on disk are common in routes made on Windows
+    if (auto itr = lowercaseFiles.find(lowercase(key)); itr != lowercaseFiles.end())
+    {
+        return itr->second;
+    }
+
+    return {};
+}
+
+vsg::Options::FindFileCallback FileIndex::findFileCallback()
+{
+    vsg::ref_ptr<FileIndex> index(this);
+    return [index](const vsg::Path& filename, const vsg::Options* options) -> vsg::Path {
+        if (index->covers(filename))
+        {
+            return index->find(filename);
+        }
+
+        if (vsg::fileExists(filename))
+        {
+            return filename;
+        }
+        return options ? vsg::findFile(filename, options->paths) : vsg::Path();
+    };
+}
@@ -0,0 +1,138 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+static const std::pair<const char*, double FrameRecord::*> frameFields[] = {
+    {"handle_events", &FrameRecord::handleEvents},
+    {"update", &FrameRecord::update},
+    {"record_and_submit", &FrameRecord::recordAndSubmit},
+    {"housekeeping", &FrameRecord::housekeeping},
+    {"present", &FrameRecord::present},
+    {"total", &FrameRecord::total},
+};
+
+FrameStats::FrameStats(size_t in_capacity)
+    : records(std::max<size_t>(in_capacity, 1))
+{
+}
+
+void FrameStats::add(const FrameRecord& record)
+{
+    records[count % records.size()] = record;
+    ++count;
+}
+
+size_t FrameStats::numHitches() const
+{
+    const size_t n = size();
+    return static_cast<size_t>(std::count_if(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(n), [this](const FrameRecord& record) { return record.total > hitchThreshold; }));
+}
+
+const FrameRecord& FrameStats::recent(size_t index) const
+{
+    return records[(count - 1 - index) % records.size()];
+}
+
+FrameStats::Summary FrameStats::summary(double FrameRecord::*field) const
+{
+    Summary result;
+
+    const size_t n = size();
+    if (n == 0)
+    {
+        return result;
+    }
+
+    std::vector<double> values(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        values[i] = records[i].*field;
+    }
+
+    auto percentile = [&values](double fraction) {
+        const size_t index = std::min(static_cast<size_t>(fraction * values.size()), values.size() - 1);
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    };
+
+    result.p50 = percentile(0.50);
+    result.p95 = percentile(0.95);
+    result.p99 = percentile(0.99);
+    result.max = *std::max_element(values.begin(), values.end());
+    return result;
+}
+
+void FrameStats::print(std::ostream& out) const
+{
+    out << "Frame times over " << size() << " frames (ms)      p50      p95      p99      max\n";
+    for (const auto& [name, field] : frameFields)
+    {
+        const Summary s = summary(field);
+        out << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(9) << s.p50 << std::setw(9) << s.p95 << std::setw(9) << s.p99 << std::setw(9) << s.max << '\n';
+    }
+    out << std::defaultfloat << "Hitches over " << hitchThreshold << " ms: " << numHitches() << '\n';
+}
+
+bool FrameStats::write(const vsg::Path& file) const
+{
+    std::ofstream out(file);
+    if (!out)
+    {
+        return false;
+    }
+
+    return vsg::lowerCaseFileExtension(file) == ".json" ? writeJson(out) : writeCsv(out);
+}
+
+bool FrameStats::writeCsv(std::ostream& out) const
+{
+    out << "frame";
+    for (const auto& [name, field] : frameFields)
+    {
+        out << ',' << name;
+    }
+    out << ",active_requests,prefetched\n";
+
+    for (size_t i = size(); i-- > 0;)
+    {
+        const FrameRecord& record = recent(i);
+        out << record.frameCount;
+        for (const auto& [name, field] : frameFields)
+        {
+            out << ',' << record.*field;
+        }
+        out << ',' << record.activeRequests << ',' << record.prefetched << '\n';
+    }
+
+    return static_cast<bool>(out);
+}
+
+bool FrameStats::writeJson(std::ostream& out) const
+{
+    out << "{\n  \"hitch_threshold_ms\": " << hitchThreshold << ",\n  \"hitches\": " << numHitches() << ",\n  \"summary\": {\n";
+    for (size_t f = 0; f < std::size(frameFields); ++f)
+    {
+        const Summary s = summary(frameFields[f].second);
+        out << "    \"" << frameFields[f].first << "\": {\"p50\": " << s.p50 << ", \"p95\": " << s.p95 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << '}'
+            << (f + 1 < std::size(frameFields) ? ",\n" : "\n");
+    }
+    out << "  },\n  \"frames\": [\n";
+
+    for (size_t i = size(); i-- > 0;)
+    {
+        const FrameRecord& record = recent(i);
+        out << "    {\"frame\": " << record.frameCount;
+        for (const auto& [name, field] : frameFields)
+        {
+            out << ", \"" << name << "\": " << record.*field;
+        }
+        out << ", \"active_requests\": " << record.activeRequests << ", \"prefetched\": " << record.prefetched << '}'
+            << (i > 0 ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,157 @@
+#include "FrustumCuller.h"
+
+#include <bitset>
+#include <cfloat>
+
+void FrustumCuller::build(const std::vector<vsg::dsphere>& spheres)
+{
+    count = spheres.size();
+
+    vsg::dbox bounds;
+    for (const vsg::dsphere& sphere : spheres)
+    {
+        bounds.add(sphere.center);
+    }
+    origin = count > 0 ? (bounds.min + bounds.max) * 0.5 : vsg::dvec3(0.0, 0.0, 0.0);
+
+    const size_t padded = (count + 63) & ~size_t(63);
+    centerX.assign(padded, 0.0f);
+    centerY.assign(padded, 0.0f);
+    centerZ.assign(padded, 0.0f);
+    radius.assign(padded, -FLT_MAX);
+    visibility.assign(padded / 64, 0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const vsg::dvec3 center = spheres[i].center - origin;
+        centerX[i] = static_cast<float>(center.x);
+        centerY[i] = static_cast<float>(center.y);
+        centerZ[i] = static_cast<float>(center.z);
+        radius[i] = static_cast<float>(spheres[i].radius);
+    }
+}
+
+void FrustumCuller::set(size_t index, const vsg::dsphere& sphere)
+{
+    const vsg::dvec3 center = sphere.center - origin;
+    centerX[index] = static_cast<float>(center.x);
+    centerY[index] = static_cast<float>(center.y);
+    centerZ[index] = static_cast<float>(center.z);
+    radius[index] = static_cast<float>(sphere.radius);
+}
+
+FrustumCuller::Planes FrustumCuller::frustumPlanes(const vsg::dmat4& m)
+{
+    // rows of the column major matrix
+    const vsg::dvec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const vsg::dvec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const vsg::dvec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const vsg::dvec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Planes planes{row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2};
+    for (vsg::dvec4& plane : planes)
+    {
+        const double length = vsg::length(vsg::dvec3(plane.x, plane.y, plane.z));
+        if (length > 0.0)
+        {
+            plane /= length;
+        }
+    }
+    return planes;
+}
+
+FrustumCuller::Planes FrustumCuller::shadowCasterPlanes(const Planes& frustum, const vsg::dvec3& eye, double shadowDistance, const vsg::dvec3& lightDirection)
+{
+    Planes planes = frustum;
+
+    // receivers end at the shadow distance; the eye lies just outside the near plane, which is the fifth or the
+    // sixth depending on whether depth is reversed, and its normal is the view direction
+    const double distance4 = frustum[4].x * eye.x + frustum[4].y * eye.y + frustum[4].z * eye.z + frustum[4].w;
+    const size_t nearIndex = distance4 < 0.0 ? 4 : 5;
+    const vsg::dvec3 forward(frustum[nearIndex].x, frustum[nearIndex].y, frustum[nearIndex].z);
+    planes[9 - nearIndex] = vsg::dvec4(-forward.x, -forward.y, -forward.z, vsg::dot(forward, eye) + shadowDistance);
+
+    // moving towards the light never leaves a plane facing it, the planes facing away are left behind; dropping
+    // them gives a convex superset of the swept volume without working out its silhouette planes
+    for (vsg::dvec4& plane : planes)
+    {
+        if (plane.x * lightDirection.x + plane.y * lightDirection.y + plane.z * lightDirection.z > 0.0)
+        {
+            plane = vsg::dvec4(0.0, 0.0, 0.0, 1.0);
+        }
+    }
+    return planes;
+}
+
+size_t FrustumCuller::cull(const Planes& planes, double margin)
+{
+    return cull(planes, visibility, margin);
+}
+
+size_t FrustumCuller::cull(const Planes& planes, std::vector<uint64_t>& bits, double margin) const
+{
+    bits.resize(visibility.size());
+
+    // move the planes into the coordinate frame of the stored centres
+    float localPlanes[6][4];
+    for (size_t p = 0; p < planes.size(); ++p)
+    {
+        const vsg::dvec4& plane = planes[p];
+        localPlanes[p][0] = static_cast<float>(plane.x);
+        localPlanes[p][1] = static_cast<float>(plane.y);
+        localPlanes[p][2] = static_cast<float>(plane.z);
+        localPlanes[p][3] = static_cast<float>(plane.w + plane.x * origin.x + plane.y * origin.y + plane.z * origin.z + margin);
+    }
+
+    if (useAvx2)
+    {
+        cull_spheres_avx2(centerX.data(), centerY.data(), centerZ.data(), radius.data(), centerX.size(), localPlanes, bits.data());
+    }
+    else
+    {
+        cull_spheres_scalar(centerX.data(), centerY.data(), centerZ.data(), radius.data(), centerX.size(), localPlanes, bits.data());
+    }
+
+    size_t numVisible = 0;
+    for (uint64_t word : bits)
+    {
+        numVisible += std::bitset<64>(word).count();
+    }
+    return numVisible;
+}
+
+void cull_spheres_scalar(const float* x, const float* y, const float* z, const float* r, size_t count, const float (*planes)[4], uint64_t* bits)
+{
+    for (size_t block = 0; block < count; block += 64)
+    {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; ++j)
+        {
+            const size_t i = block + j;
+            bool inside = true;
+            for (size_t p = 0; p < 6; ++p)
+            {
+                const float distance = planes[p][0] * x[i] + planes[p][1] * y[i] + planes[p][2] * z[i] + planes[p][3];
+                inside = inside && (distance + r[i] >= 0.0f);
+            }
+            word |= static_cast<uint64_t>(inside) << j;
+        }
+        bits[block / 64] = word;
+    }
+}
+
+#ifndef ROUTE_CULL_AVX2
+void cull_spheres_avx2(const float* x, const float* y, const float* z, const float* r, size_t count, const float (*planes)[4], uint64_t* bits)
+{
+    cull_spheres_scalar(x, y, z, r, count, planes, bits);
+}
+#endif
+
+bool FrustumCuller::avx2Supported()
+{
+#if defined(ROUTE_CULL_AVX2) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
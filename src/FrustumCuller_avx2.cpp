@@ -0,0 +1,43 @@
+// built with -mavx2, only called after FrustumCuller::avx2Supported()
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+void cull_spheres_avx2(const float* x, const float* y, const float* z, const float* r, size_t count, const float (*planes)[4], uint64_t* bits)
+{
+    __m256 nx[6], ny[6], nz[6], d[6];
+    for (size_t p = 0; p < 6; ++p)
+    {
+        nx[p] = _mm256_set1_ps(planes[p][0]);
+        ny[p] = _mm256_set1_ps(planes[p][1]);
+        nz[p] = _mm256_set1_ps(planes[p][2]);
+        d[p] = _mm256_set1_ps(planes[p][3]);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (size_t block = 0; block < count; block += 64)
+    {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8)
+        {
+            const size_t i = block + j;
+            const __m256 cx = _mm256_loadu_ps(x + i);
+            const __m256 cy = _mm256_loadu_ps(y + i);
+            const __m256 cz = _mm256_loadu_ps(z + i);
+            const __m256 cr = _mm256_loadu_ps(r + i);
+
+            // same operation order as the scalar kernel, so both give identical bits
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (size_t p = 0; p < 6; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)), _mm256_mul_ps(nz[p], cz)), d[p]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, cr), zero, _CMP_GE_OQ));
+            }
+
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(inside))) << j;
+        }
+        bits[block / 64] = word;
+    }
+}
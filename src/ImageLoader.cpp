@@ -0,0 +1,39 @@
+#include "ImageLoader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <stb_image.h>
+
+vsg::ref_ptr<vsg::ubvec4Array2D> loadImage(const vsg::Path& file)
+{
+    // the flip flag is thread local, the loader is called from the pager threads
+    stbi_set_flip_vertically_on_load_thread(vsg::fileExtension(file) == ".bmp" ? 1 : 0);
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(file.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        return {};
+    }
+
+    // copy into memory allocated by vsg, stb_image memory has to be released with stbi_image_free
+    auto image = vsg::ubvec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+    std::memcpy(image->dataPointer(), pixels, image->dataSize());
+    stbi_image_free(pixels);
+
+    image->setValue("transparent", hasTransparency(*image));
+
+    return image;
+}
+
+bool readImageSize(const vsg::Path& file, int& width, int& height)
+{
+    int channels;
+    return stbi_info(file.string().c_str(), &width, &height, &channels) != 0;
+}
+
+bool hasTransparency(const vsg::ubvec4Array2D& image)
+{
+    return std::any_of(image.begin(), image.end(), [](const vsg::ubvec4& texel) { return texel.a < 255; });
+}
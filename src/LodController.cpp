@@ -0,0 +1,61 @@
+#include "LodController.h"
+
+#include <algorithm>
+
+bool LodController::update(double frameTime, uint32_t activeRequests, const std::vector<PagedObject>& objects, vsg::ViewDependentState* viewDependentState)
+{
+    if (cooldown > 0)
+    {
+        --cooldown;
+        return false;
+    }
+
+    frameTimeSum += frameTime;
+    backlogMax = std::max(backlogMax, activeRequests);
+    if (++numSamples < windowFrames)
+    {
+        return false;
+    }
+
+    const double average = frameTimeSum / numSamples;
+    const bool backlogged = backlogMax > maxBacklog;
+    const bool loading = backlogMax > minBacklog || activeRequests > 0;
+    frameTimeSum = 0.0;
+    backlogMax = 0;
+    numSamples = 0;
+
+    double newScale = scale;
+    if (average > targetFrameTime * (1.0 + hysteresis) || backlogged)
+    {
+        newScale = std::max(minimumScale, scale - decreaseStep);
+    }
+    else if (average < targetFrameTime * (1.0 - hysteresis) && !loading)
+    {
+        newScale = std::min(1.0, scale + increaseStep);
+    }
+
+    if (newScale == scale)
+    {
+        return false;
+    }
+
+    (newScale < scale ? numDecreases : numIncreases)++;
+    scale = newScale;
+    apply(objects, viewDependentState);
+    cooldown = cooldownFrames;
+    return true;
+}
+
+void LodController::apply(const std::vector<PagedObject>& objects, vsg::ViewDependentState* viewDependentState) const
+{
+    const double ratio = baseRatio / scale;
+    for (const PagedObject& object : objects)
+    {
+        object.pagedLod->children[0].minimumScreenHeightRatio = ratio;
+    }
+
+    if (viewDependentState)
+    {
+        viewDependentState->maxShadowDistance = baseShadowDistance * scale;
+    }
+}
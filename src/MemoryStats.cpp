@@ -0,0 +1,175 @@
+#include "MemoryStats.h"
+
+#include "ResidencyManager.h"
+
+#include <iomanip>
+#include <unordered_set>
+
+void MemoryStats::created(size_t vertexBytes, size_t indexBytes)
+{
+    ++modelsCreated;
+    vertexBytesCreated += vertexBytes;
+    indexBytesCreated += indexBytes;
+}
+
+void MemoryStats::evicted(size_t bytes)
+{
+    ++placementsEvicted;
+    bytesEvicted += bytes;
+}
+
+void MemoryStats::update(const std::vector<PagedObject>& objects)
+{
+    resident.resize(objects.size(), false);
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        const bool loaded = objects[i].pagedLod->children[0].node.valid();
+        if (loaded != resident[i])
+        {
+            (loaded ? placementsLoaded : placementsExpired)++;
+            resident[i] = loaded;
+        }
+    }
+}
+
+// counts every node, state command and array once, however many parents share it
+class NodeCounter : public vsg::Inherit<vsg::ConstVisitor, NodeCounter>
+{
+public:
+    std::map<std::string, size_t>& nodes;
+    std::map<std::string, size_t>& objects;
+    std::unordered_set<const vsg::Object*> visited;
+
+    NodeCounter(std::map<std::string, size_t>& in_nodes, std::map<std::string, size_t>& in_objects)
+        : nodes(in_nodes), objects(in_objects)
+    {
+    }
+
+    void apply(const vsg::Node& node) override
+    {
+        if (visited.insert(&node).second)
+        {
+            ++nodes[node.className()];
+            node.traverse(*this);
+        }
+    }
+
+    void apply(const vsg::StateGroup& stateGroup) override
+    {
+        if (visited.insert(&stateGroup).second)
+        {
+            ++nodes[stateGroup.className()];
+            for (auto& stateCommand : stateGroup.stateCommands)
+            {
+                count(stateCommand.get());
+            }
+            stateGroup.traverse(*this);
+        }
+    }
+
+    void apply(const vsg::BindVertexBuffers& bindVertexBuffers) override
+    {
+        if (visited.insert(&bindVertexBuffers).second)
+        {
+            ++nodes[bindVertexBuffers.className()];
+            for (auto& array : bindVertexBuffers.arrays)
+            {
+                count(array->data.get());
+            }
+        }
+    }
+
+    void apply(const vsg::BindIndexBuffer& bindIndexBuffer) override
+    {
+        if (visited.insert(&bindIndexBuffer).second)
+        {
+            ++nodes[bindIndexBuffer.className()];
+            if (bindIndexBuffer.indices)
+            {
+                count(bindIndexBuffer.indices->data.get());
+            }
+        }
+    }
+
+private:
+    void count(const vsg::Object* object)
+    {
+        if (object && visited.insert(object).second)
+        {
+            ++objects[object->className()];
+        }
+    }
+};
+
+MemoryReport MemoryStats::collect(const std::vector<PagedObject>& objects, const vsg::Node* sceneGraph) const
+{
+    MemoryReport report;
+
+    std::unordered_set<const vsg::Node*> models;
+    std::unordered_set<const vsg::Data*> textures;
+    for (const PagedObject& object : objects)
+    {
+        const vsg::Node* child = object.pagedLod->children[0].node.get();
+        if (!child)
+        {
+            continue;
+        }
+
+        ++report.numResident;
+        if (!models.insert(child).second)
+        {
+            continue;
+        }
+
+        // sizes assigned by DMD_Reader when it creates the subgraph
+        size_t vertexBytes = 0, indexBytes = 0;
+        child->getValue("vertex_bytes", vertexBytes);
+        child->getValue("index_bytes", indexBytes);
+        report.vertexBytes += vertexBytes;
+        report.indexBytes += indexBytes;
+
+        size_t textureCpuBytes, textureGpuBytes;
+        if (auto texture = ResidencyManager::childTexture(child, textureCpuBytes, textureGpuBytes); texture && textures.insert(texture).second)
+        {
+            report.textureCpuBytes += textureCpuBytes;
+            report.textureGpuBytes += textureGpuBytes;
+        }
+    }
+    report.numModels = models.size();
+    report.numTextures = textures.size();
+
+    if (sceneGraph)
+    {
+        auto counter = NodeCounter::create(report.nodes, report.objects);
+        sceneGraph->accept(*counter);
+    }
+
+    return report;
+}
+
+void MemoryStats::print(std::ostream& out, const MemoryReport& report) const
+{
+    auto mib = [](size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+    out << std::fixed << std::setprecision(1);
+    out << "Memory: " << report.numResident << " resident placements, " << report.numModels << " models, " << report.numTextures << " textures\n";
+    out << "  vertex data   " << std::setw(10) << mib(report.vertexBytes) << " MiB\n";
+    out << "  index data    " << std::setw(10) << mib(report.indexBytes) << " MiB\n";
+    out << "  textures CPU  " << std::setw(10) << mib(report.textureCpuBytes) << " MiB\n";
+    out << "  textures GPU  " << std::setw(10) << mib(report.textureGpuBytes) << " MiB\n";
+    out << "  created       " << modelsCreated << " models, " << mib(vertexBytesCreated + indexBytesCreated) << " MiB geometry since startup\n";
+    out << "  placements    " << placementsLoaded << " loaded, " << placementsExpired << " expired, " << placementsEvicted << " of them evicted ("
+        << mib(bytesEvicted) << " MiB) since startup\n";
+
+    out << "  nodes:";
+    for (auto& [className, count] : report.nodes)
+    {
+        out << ' ' << className << '=' << count;
+    }
+    out << "\n  objects:";
+    for (auto& [className, count] : report.objects)
+    {
+        out << ' ' << className << '=' << count;
+    }
+    out << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,341 @@
+#include "OcclusionCuller.h"
+
+#include "DMD_Reader.h"
+#include "FrustumCuller.h"
+#include "ImageLoader.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+OcclusionCuller::OcclusionCuller(uint32_t in_width, uint32_t in_height)
+    : width((std::max(4u, in_width) + 3) & ~3u), height(std::max(1u, in_height)), depth(width * height, 0.0f)
+{
+}
+
+void OcclusionCuller::render(const std::vector<Occluder>& occluders, const vsg::dmat4& in_projectionView, const vsg::dvec3& eye)
+{
+    TRACE_SCOPE("occlusion render");
+
+    projectionView = in_projectionView;
+    std::fill(depth.begin(), depth.end(), 0.0f);
+    numOccluders = 0;
+    numTriangles = 0;
+    numTested = 0;
+    numOccluded = 0;
+
+    const FrustumCuller::Planes planes = FrustumCuller::frustumPlanes(projectionView);
+
+    std::vector<std::pair<double, const Occluder*>> candidates;
+    for (const Occluder& occluder : occluders)
+    {
+        const vsg::dvec3& center = occluder.bound.center;
+        const double distance = vsg::length(center - eye) - occluder.bound.radius;
+        if (distance > occluderDistance)
+        {
+            continue;
+        }
+
+        bool inside = true;
+        for (const vsg::dvec4& plane : planes)
+        {
+            inside = inside && (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w >= -occluder.bound.radius);
+        }
+        if (inside)
+        {
+            candidates.emplace_back(distance, &occluder);
+        }
+    }
+
+    // the nearest occluders cover the most pixels, draw order itself doesn't matter
+    if (candidates.size() > maxOccluders)
+    {
+        std::nth_element(candidates.begin(), candidates.begin() + maxOccluders, candidates.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        candidates.resize(maxOccluders);
+    }
+
+    for (const auto& [distance, occluder] : candidates)
+    {
+        // clip coordinates stay small, so the combined matrix is precise enough in floats
+        const vsg::mat4 matrix(projectionView * occluder->matrix);
+        const vsg::vec3Array& triangles = *occluder->triangles;
+        for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+        {
+            const vsg::vec3& v0 = triangles[i];
+            const vsg::vec3& v1 = triangles[i + 1];
+            const vsg::vec3& v2 = triangles[i + 2];
+            rasterizeTriangle(matrix * vsg::vec4(v0.x, v0.y, v0.z, 1.0f), matrix * vsg::vec4(v1.x, v1.y, v1.z, 1.0f), matrix * vsg::vec4(v2.x, v2.y, v2.z, 1.0f));
+        }
+        ++numOccluders;
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const vsg::vec4& c0, const vsg::vec4& c1, const vsg::vec4& c2)
+{
+    // clipping against the near plane would add triangles, skipping them only loses occlusion
+    const float nearW = static_cast<float>(nearDistance);
+    if (c0.w < nearW || c1.w < nearW || c2.w < nearW)
+    {
+        return;
+    }
+
+    const float w = static_cast<float>(width);
+    const float h = static_cast<float>(height);
+    float x0 = (c0.x / c0.w * 0.5f + 0.5f) * w, y0 = (c0.y / c0.w * 0.5f + 0.5f) * h, z0 = 1.0f / c0.w;
+    float x1 = (c1.x / c1.w * 0.5f + 0.5f) * w, y1 = (c1.y / c1.w * 0.5f + 0.5f) * h, z1 = 1.0f / c1.w;
+    float x2 = (c2.x / c2.w * 0.5f + 0.5f) * w, y2 = (c2.y / c2.w * 0.5f + 0.5f) * h, z2 = 1.0f / c2.w;
+
+    float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+    if (std::abs(area) < 1e-6f)
+    {
+        return;
+    }
+    if (area < 0.0f)
+    {
+        // either winding occludes
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+        std::swap(z1, z2);
+        area = -area;
+    }
+
+    const int minX = std::max(0, static_cast<int>(std::floor(std::min({x0, x1, x2}))));
+    const int maxX = std::min(static_cast<int>(width) - 1, static_cast<int>(std::ceil(std::max({x0, x1, x2}))));
+    const int minY = std::max(0, static_cast<int>(std::floor(std::min({y0, y1, y2}))));
+    const int maxY = std::min(static_cast<int>(height) - 1, static_cast<int>(std::ceil(std::max({y0, y1, y2}))));
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+    ++numTriangles;
+
+    // edge functions a * x + b * y + c, positive inside, each one is the barycentric weight of the opposite vertex
+    const float a12 = y1 - y2, b12 = x2 - x1, c12 = x1 * y2 - x2 * y1;
+    const float a20 = y2 - y0, b20 = x0 - x2, c20 = x2 * y0 - x0 * y2;
+    const float a01 = y0 - y1, b01 = x1 - x0, c01 = x0 * y1 - x1 * y0;
+
+    // 1/w is linear in screen space
+    const float za = (a12 * z0 + a20 * z1 + a01 * z2) / area;
+    const float zb = (b12 * z0 + b20 * z1 + b01 * z2) / area;
+    const float zc = (c12 * z0 + c20 * z1 + c01 * z2) / area;
+
+    // rows start on a multiple of four, the width is one, so every block of four lies inside the buffer
+    for (int y = minY; y <= maxY; ++y)
+    {
+        const float py = static_cast<float>(y) + 0.5f;
+        float* row = depth.data() + static_cast<size_t>(y) * width;
+
+#if defined(__SSE2__)
+        const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 e12Row = _mm_set1_ps(b12 * py + c12), e20Row = _mm_set1_ps(b20 * py + c20), e01Row = _mm_set1_ps(b01 * py + c01);
+        const __m128 zRow = _mm_set1_ps(zb * py + zc);
+        for (int x = minX & ~3; x <= maxX; x += 4)
+        {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+            const __m128 e12 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a12), px), e12Row);
+            const __m128 e20 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a20), px), e20Row);
+            const __m128 e01 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a01), px), e01Row);
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e12, zero), _mm_cmpge_ps(e20, zero)), _mm_cmpge_ps(e01, zero));
+            const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), zRow);
+            _mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), _mm_and_ps(inside, z)));
+        }
+#else
+        for (int x = minX; x <= maxX; ++x)
+        {
+            const float px = static_cast<float>(x) + 0.5f;
+            if (a12 * px + b12 * py + c12 >= 0.0f && a20 * px + b20 * py + c20 >= 0.0f && a01 * px + b01 * py + c01 >= 0.0f)
+            {
+                row[x] = std::max(row[x], za * px + zb * py + zc);
+            }
+        }
+#endif
+    }
+}
+
+bool OcclusionCuller::occluded(const vsg::dsphere& sphere)
+{
+    ++numTested;
+
+    // the w row of a perspective projection times a rigid view matrix is the unit view direction
+    const vsg::dvec3& center = sphere.center;
+    const double radius = sphere.radius;
+    const vsg::dvec4 clipCenter = projectionView * vsg::dvec4(center.x, center.y, center.z, 1.0);
+    const double nearest = clipCenter.w - radius;
+    if (nearest <= nearDistance)
+    {
+        return false;
+    }
+
+    // screen rectangle of the corners of the box around the sphere
+    double minX = width, maxX = 0.0, minY = height, maxY = 0.0;
+    for (int i = 0; i < 8; ++i)
+    {
+        const vsg::dvec4 corner(center.x + ((i & 1) ? radius : -radius), center.y + ((i & 2) ? radius : -radius), center.z + ((i & 4) ? radius : -radius), 1.0);
+        const vsg::dvec4 clip = projectionView * corner;
+        if (clip.w <= 0.0)
+        {
+            return false;
+        }
+
+        const double x = (clip.x / clip.w * 0.5 + 0.5) * width;
+        const double y = (clip.y / clip.w * 0.5 + 0.5) * height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+
+    if (maxX < 0.0 || minX >= width || maxY < 0.0 || minY >= height)
+    {
+        // off screen, that is for the frustum culler to decide
+        return false;
+    }
+
+    // occluders mark the pixels whose centre they cover, so test one more pixel on each side: every point of
+    // the rectangle then lies between covered pixel centres, and a sphere showing past an occluder's edge by
+    // less than a pixel is still reported visible
+    const int x0 = std::max(0, static_cast<int>(std::floor(minX)) - 1);
+    const int x1 = std::min(static_cast<int>(width) - 1, static_cast<int>(std::floor(maxX)) + 1);
+    const int y0 = std::max(0, static_cast<int>(std::floor(minY)) - 1);
+    const int y1 = std::min(static_cast<int>(height) - 1, static_cast<int>(std::floor(maxY)) + 1);
+
+    const float limit = static_cast<float>(1.0 / nearest);
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* row = depth.data() + static_cast<size_t>(y) * width;
+
+#if defined(__SSE2__)
+        const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 first = _mm_set1_ps(static_cast<float>(x0));
+        const __m128 last = _mm_set1_ps(static_cast<float>(x1));
+        const __m128 threshold = _mm_set1_ps(limit);
+        for (int x = x0 & ~3; x <= x1; x += 4)
+        {
+            const __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+            const __m128 covered = _mm_and_ps(_mm_cmpge_ps(index, first), _mm_cmple_ps(index, last));
+            if (_mm_movemask_ps(_mm_and_ps(covered, _mm_cmple_ps(_mm_loadu_ps(row + x), threshold))) != 0)
+            {
+                return false;
+            }
+        }
+#else
+        for (int x = x0; x <= x1; ++x)
+        {
+            if (row[x] <= limit)
+            {
+                return false;
+            }
+        }
+#endif
+    }
+
+    ++numOccluded;
+    return true;
+}
+
+vsg::ref_ptr<vsg::vec3Array> OcclusionCuller::createOccluderTriangles(const ModelData& model, size_t maxTriangles)
+{
+    const vsg::vec3Array& vertices = *model.vertices;
+    const vsg::ushortArray& indices = *model.indices;
+
+    // area and first index of every triangle
+    std::vector<std::pair<float, size_t>> triangles;
+    triangles.reserve(indices.size() / 3);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const vsg::vec3& v0 = vertices[indices[i]];
+        const float area = vsg::length(vsg::cross(vertices[indices[i + 1]] - v0, vertices[indices[i + 2]] - v0));
+        if (area > 0.0f)
+        {
+            triangles.emplace_back(area, i);
+        }
+    }
+
+    const size_t count = std::min(maxTriangles, triangles.size());
+    std::partial_sort(triangles.begin(), triangles.begin() + count, triangles.end(),
+                      [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    auto result = vsg::vec3Array::create(static_cast<uint32_t>(count * 3));
+    for (size_t t = 0; t < count; ++t)
+    {
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            (*result)[t * 3 + corner] = vertices[indices[triangles[t].second + corner]];
+        }
+    }
+    return result;
+}
+
+std::vector<Occluder> OcclusionCuller::createOccluders(const Route& route, vsg::ref_ptr<const vsg::Options> options, double minimumRadius, size_t maxTriangles)
+{
+    // each model is parsed once, bound in model space
+    struct OccluderModel
+    {
+        bool parsed = false;
+        vsg::ref_ptr<vsg::vec3Array> triangles;
+        vsg::dsphere bound;
+    };
+    std::vector<OccluderModel> models(route.assets->numModels());
+
+    // refs whose texture has see-through texels are drawn alpha tested, their solid triangles would hide what shows
+    // through; a missing texture gets the opaque placeholder
+    std::vector<int8_t> transparentTextures(route.assets->numTextures(), -1);
+    auto transparent = [&](uint32_t textureId) {
+        int8_t& state = transparentTextures[textureId];
+        if (state < 0)
+        {
+            const vsg::Path textureFile = vsg::findFile(route.assets->texturePath(textureId), options);
+            auto image = textureFile ? loadImage(textureFile) : vsg::ref_ptr<vsg::ubvec4Array2D>();
+            state = image && hasTransparency(*image) ? 1 : 0;
+        }
+        return state == 1;
+    };
+
+    std::vector<Occluder> occluders;
+    for (const ObjectTransformation& transformation : route.objectTransformations)
+    {
+        const ObjectRef& ref = route.objectsRef[transformation.referenceId];
+        if (!ref.occluder && minimumRadius <= 0.0)
+        {
+            continue;
+        }
+
+        OccluderModel& model = models[ref.modelId];
+        if (!model.parsed)
+        {
+            model.parsed = true;
+
+            const vsg::Path modelFile = vsg::findFile(route.assets->modelPath(ref.modelId), options);
+            auto modelData = modelFile ? DMD_Reader::load_model(modelFile) : vsg::ref_ptr<ModelData>();
+            if (modelData && modelData->vertices->size() > 0)
+            {
+                vsg::box bounds;
+                for (const vsg::vec3& vertex : *modelData->vertices)
+                {
+                    bounds.add(vertex);
+                }
+                model.bound.set(vsg::dvec3((bounds.min + bounds.max) * 0.5f), vsg::length(bounds.max - bounds.min) * 0.5);
+                model.triangles = createOccluderTriangles(*modelData, maxTriangles);
+            }
+        }
+
+        if (!model.triangles || model.triangles->size() == 0 || (!ref.occluder && model.bound.radius < minimumRadius) || transparent(ref.textureId))
+        {
+            continue;
+        }
+
+        Occluder occluder;
+        occluder.triangles = model.triangles;
+        occluder.matrix = Route::placementMatrix(transformation);
+        occluder.bound.set(occluder.matrix * model.bound.center, model.bound.radius);
+        occluders.push_back(occluder);
+    }
+
+    return occluders;
+}
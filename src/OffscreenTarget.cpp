@@ -0,0 +1,197 @@
+#include "OffscreenTarget.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+OffscreenTarget::OffscreenTarget(const VkExtent2D& in_extent, bool debugLayer)
+    : extent(in_extent)
+{
+    vsg::Names instanceExtensions;
+    vsg::Names layers;
+    if (debugLayer && vsg::isExtensionSupported(VK_EXT_DEBUG_UTILS_EXTENSION_NAME))
+    {
+        instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        layers.push_back("VK_LAYER_KHRONOS_validation");
+    }
+
+    instance = vsg::Instance::create(instanceExtensions, vsg::validateInstancelayerNames(layers));
+
+    // no surface to present to, any device with a graphics queue will do
+    auto [physicalDevice, family] = instance->getPhysicalDeviceAndQueueFamily(VK_QUEUE_GRAPHICS_BIT);
+    if (!physicalDevice || family < 0)
+    {
+        throw std::runtime_error("Failed to find a Vulkan device with a graphics queue!");
+    }
+    queueFamily = family;
+
+    vsg::info("OffscreenTarget: rendering on ", physicalDevice->getProperties().deviceName);
+
+    auto deviceFeatures = vsg::DeviceFeatures::create();
+    deviceFeatures->get().samplerAnisotropy = physicalDevice->getFeatures().samplerAnisotropy;
+
+    vsg::QueueSettings queueSettings{vsg::QueueSetting{queueFamily, {1.0}}};
+    device = vsg::Device::create(physicalDevice, queueSettings, vsg::validateInstancelayerNames(layers), vsg::Names{}, deviceFeatures);
+
+    colorImageView = createAttachment(colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    auto depthImageView = createAttachment(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+    framebuffer = vsg::Framebuffer::create(createRenderPass(), vsg::ImageViews{colorImageView, depthImageView}, extent.width, extent.height, 1);
+}
+
+vsg::ref_ptr<vsg::ImageView> OffscreenTarget::createAttachment(VkFormat format, VkImageUsageFlags usage) const
+{
+    auto image = vsg::Image::create();
+    image->imageType = VK_IMAGE_TYPE_2D;
+    image->format = format;
+    image->extent = VkExtent3D{extent.width, extent.height, 1};
+    image->mipLevels = 1;
+    image->arrayLayers = 1;
+    image->samples = VK_SAMPLE_COUNT_1_BIT;
+    image->tiling = VK_IMAGE_TILING_OPTIMAL;
+    image->usage = usage;
+    image->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    return vsg::createImageView(device, image, vsg::computeAspectFlagsForFormat(format));
+}
+
+vsg::ref_ptr<vsg::RenderPass> OffscreenTarget::createRenderPass() const
+{
+    auto colorAttachment = vsg::defaultColorAttachment(colorFormat);
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    auto depthAttachment = vsg::defaultDepthAttachment(depthFormat);
+
+    vsg::AttachmentReference colorReference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    vsg::AttachmentReference depthReference = {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+    vsg::SubpassDescription subpass;
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachments.emplace_back(colorReference);
+    subpass.depthStencilAttachments.emplace_back(depthReference);
+
+    constexpr VkPipelineStageFlags attachmentStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    constexpr VkAccessFlags attachmentWrites = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    // the previous frame's capture reads the colour attachment before this frame writes it
+    vsg::SubpassDependency beginDependency = {
+        VK_SUBPASS_EXTERNAL, 0,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | attachmentStages, attachmentStages,
+        VK_ACCESS_TRANSFER_READ_BIT, attachmentWrites,
+        0};
+
+    vsg::SubpassDependency endDependency = {
+        0, VK_SUBPASS_EXTERNAL,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+        0};
+
+    vsg::RenderPass::Attachments attachments{colorAttachment, depthAttachment};
+    vsg::RenderPass::Subpasses subpasses{subpass};
+    vsg::RenderPass::Dependencies dependencies{beginDependency, endDependency};
+
+    return vsg::RenderPass::create(device, attachments, subpasses, dependencies);
+}
+
+vsg::ref_ptr<vsg::RenderGraph> OffscreenTarget::createRenderGraph(vsg::ref_ptr<vsg::View> view) const
+{
+    auto renderGraph = vsg::RenderGraph::create();
+    renderGraph->framebuffer = framebuffer;
+    renderGraph->renderArea.offset = {0, 0};
+    renderGraph->renderArea.extent = extent;
+    renderGraph->setClearValues({{0.2f, 0.2f, 0.4f, 1.0f}}, VkClearDepthStencilValue{0.0f, 0});
+    renderGraph->addChild(view);
+    return renderGraph;
+}
+
+vsg::ref_ptr<vsg::Commands> OffscreenTarget::createCaptureCommands()
+{
+    captureImage = vsg::Image::create();
+    captureImage->imageType = VK_IMAGE_TYPE_2D;
+    captureImage->format = colorFormat;
+    captureImage->extent = VkExtent3D{extent.width, extent.height, 1};
+    captureImage->mipLevels = 1;
+    captureImage->arrayLayers = 1;
+    captureImage->samples = VK_SAMPLE_COUNT_1_BIT;
+    captureImage->tiling = VK_IMAGE_TILING_LINEAR;
+    captureImage->usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    captureImage->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    captureImage->compile(device);
+
+    auto deviceMemory = vsg::DeviceMemory::create(device, captureImage->getMemoryRequirements(device->deviceID),
+                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    captureImage->bind(deviceMemory, 0);
+
+    const VkImageSubresourceRange colorRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    auto toTransferDestination = vsg::ImageMemoryBarrier::create(
+        0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        captureImage, colorRange);
+
+    VkImageCopy region{};
+    region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.extent = VkExtent3D{extent.width, extent.height, 1};
+
+    auto copyImage = vsg::CopyImage::create();
+    copyImage->srcImage = colorImageView->image;
+    copyImage->srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    copyImage->dstImage = captureImage;
+    copyImage->dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    copyImage->regions.push_back(region);
+
+    auto toHostRead = vsg::ImageMemoryBarrier::create(
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        captureImage, colorRange);
+
+    auto commands = vsg::Commands::create();
+    commands->addChild(vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, toTransferDestination));
+    commands->addChild(copyImage);
+    commands->addChild(vsg::PipelineBarrier::create(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, toHostRead));
+    return commands;
+}
+
+bool OffscreenTarget::writeCapture(const vsg::Path& file) const
+{
+    if (!captureImage)
+    {
+        return false;
+    }
+
+    vkDeviceWaitIdle(*device);
+
+    VkImageSubresource subresource{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0};
+    VkSubresourceLayout layout;
+    vkGetImageSubresourceLayout(*device, captureImage->vk(device->deviceID), &subresource, &layout);
+
+    auto deviceMemory = captureImage->getDeviceMemory(device->deviceID);
+    void* mapped = nullptr;
+    if (deviceMemory->map(layout.offset, layout.size, 0, &mapped) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    std::ofstream output(file, std::ios::binary);
+    output << "P6\n" << extent.width << ' ' << extent.height << "\n255\n";
+
+    // RGBA rows with driver specific pitch to tightly packed RGB
+    std::vector<char> row(extent.width * 3);
+    for (uint32_t y = 0; y < extent.height; ++y)
+    {
+        const auto* pixels = static_cast<const uint8_t*>(mapped) + y * layout.rowPitch;
+        for (uint32_t x = 0; x < extent.width; ++x)
+        {
+            row[x * 3 + 0] = static_cast<char>(pixels[x * 4 + 0]);
+            row[x * 3 + 1] = static_cast<char>(pixels[x * 4 + 1]);
+            row[x * 3 + 2] = static_cast<char>(pixels[x * 4 + 2]);
+        }
+        output.write(row.data(), row.size());
+    }
+
+    deviceMemory->unmap();
+    return static_cast<bool>(output);
+}
@@ -0,0 +1,135 @@
+#include "PagingScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+double PagingScheduler::priority(const PagedObject& object, const vsg::dvec3& eye, const vsg::dvec3& direction) const
+{
+    const vsg::dvec3 offset = object.center - eye;
+    const double distance = std::max(vsg::length(offset), 1.0);
+
+    // proportional to the projected height, doubled for objects straight ahead and halved behind
+    const double screenSize = object.radius / distance;
+    const double alignment = vsg::length(direction) > 0.0 ? vsg::dot(offset, direction) / distance : 0.0;
+    return screenSize * (1.25 + 0.75 * alignment);
+}
+
+// both cell indices in one hash key
+static uint64_t cellKey(int64_t x, int64_t y)
+{
+    return (static_cast<uint64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+void PagingScheduler::buildGrid(const std::vector<PagedObject>& objects)
+{
+    grid.clear();
+    for (uint32_t i = 0; i < objects.size(); ++i)
+    {
+        const vsg::dvec3& center = objects[i].center;
+        grid[cellKey(static_cast<int64_t>(std::floor(center.x / cellSize)), static_cast<int64_t>(std::floor(center.y / cellSize)))].push_back(i);
+    }
+    gridSize = objects.size();
+    aheadFrame.assign(objects.size(), 0);
+    ahead.clear();
+}
+
+void PagingScheduler::update(const std::vector<PagedObject>& objects, vsg::DatabasePager& pager, const vsg::dvec3& eye, double time, uint64_t frameCount)
+{
+    if (first)
+    {
+        first = false;
+        previousEye = eye;
+        previousTime = time;
+    }
+
+    if (gridSize != objects.size())
+    {
+        buildGrid(objects);
+    }
+
+    const double deltaTime = time - previousTime;
+    if (deltaTime > 0.0)
+    {
+        // smooth the velocity so a single jittery frame doesn't flip the prefetch direction
+        const vsg::dvec3 instantVelocity = (eye - previousEye) / deltaTime;
+        const double weight = std::min(deltaTime * 4.0, 1.0);
+        cameraVelocity = cameraVelocity * (1.0 - weight) + instantVelocity * weight;
+    }
+    previousEye = eye;
+    previousTime = time;
+
+    const double speed = vsg::length(cameraVelocity);
+    const vsg::dvec3 direction = speed > 0.5 ? cameraVelocity / speed : vsg::dvec3();
+    const vsg::dvec3 predictedEye = eye + cameraVelocity * lookAheadTime;
+    const double prefetchRadius2 = prefetchRadius * prefetchRadius;
+
+    // the cells around the path to the predicted position, a cell wider as the bounds refreshed after loading
+    // can move an object's center out of the cell it was sorted into
+    const double reach = prefetchRadius + cellSize;
+    const int64_t x0 = static_cast<int64_t>(std::floor((std::min(eye.x, predictedEye.x) - reach) / cellSize));
+    const int64_t x1 = static_cast<int64_t>(std::floor((std::max(eye.x, predictedEye.x) + reach) / cellSize));
+    const int64_t y0 = static_cast<int64_t>(std::floor((std::min(eye.y, predictedEye.y) - reach) / cellSize));
+    const int64_t y1 = static_cast<int64_t>(std::floor((std::max(eye.y, predictedEye.y) + reach) / cellSize));
+
+    std::vector<std::pair<double, const PagedObject*>> prefetch;
+    std::vector<uint32_t> nowAhead;
+    for (int64_t y = y0; y <= y1; ++y)
+    {
+        for (int64_t x = x0; x <= x1; ++x)
+        {
+            auto cell = grid.find(cellKey(x, y));
+            if (cell == grid.end())
+            {
+                continue;
+            }
+
+            for (uint32_t index : cell->second)
+            {
+                const PagedObject& object = objects[index];
+
+                // between the camera and its predicted position, or around the current position when standing still
+                const vsg::dvec3 toObject = object.center - eye;
+                const double along = std::clamp(vsg::dot(toObject, direction), 0.0, speed * lookAheadTime);
+                const vsg::dvec3 nearest = eye + direction * along;
+                if (vsg::length2(object.center - nearest) > prefetchRadius2 && vsg::length2(object.center - predictedEye) > prefetchRadius2)
+                {
+                    continue;
+                }
+
+                // keeps the child from expiring and the pending request from being discarded as stale
+                vsg::PagedLOD& pagedLod = *object.pagedLod;
+                pagedLod.frameHighResLastUsed = frameCount;
+                aheadFrame[index] = frameCount;
+                nowAhead.push_back(index);
+
+                if (!pagedLod.children[0].node.valid() && pagedLod.requestStatus.load() == vsg::PagedLOD::NoRequest)
+                {
+                    prefetch.emplace_back(priority(object, eye, direction), &object);
+                }
+            }
+        }
+    }
+
+    for (uint32_t index : ahead)
+    {
+        // kept alive last frame and neither drawn nor ahead in this one, left for the reader to find stale
+        vsg::PagedLOD& pagedLod = *objects[index].pagedLod;
+        if (aheadFrame[index] != frameCount && pagedLod.requestStatus.load() == vsg::PagedLOD::ReadRequest && pagedLod.frameHighResLastUsed.load() + 1 == frameCount)
+        {
+            ++numAbandoned;
+        }
+    }
+    ahead.swap(nowAhead);
+
+    const size_t count = std::min<size_t>(prefetch.size(), maxPrefetchPerFrame);
+    std::partial_sort(prefetch.begin(), prefetch.begin() + count, prefetch.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        // the priority is only written while the PagedLOD has no request, so no pager thread is reading it
+        const PagedObject& object = *prefetch[i].second;
+        object.pagedLod->priority = prefetch[i].first;
+        pager.request(object.pagedLod);
+        ++numPrefetched;
+    }
+}
@@ -0,0 +1,60 @@
+#include "PhaseTimer.h"
+
+#include <fstream>
+#include <iomanip>
+
+PhaseTimer::Scope::Scope(PhaseTimer& in_timer, const std::string& name)
+    : timer(in_timer), index(in_timer.phases.size())
+{
+    timer.phases.push_back(Phase{name, timer.depth, timer.now(), 0.0});
+    ++timer.depth;
+}
+
+PhaseTimer::Scope::~Scope()
+{
+    --timer.depth;
+    Phase& phase = timer.phases[index];
+    phase.duration = timer.now() - phase.start;
+}
+
+PhaseTimer::PhaseTimer()
+    : origin(vsg::clock::now())
+{
+}
+
+double PhaseTimer::now() const
+{
+    return std::chrono::duration<double, std::chrono::seconds::period>(vsg::clock::now() - origin).count();
+}
+
+void PhaseTimer::print(std::ostream& out) const
+{
+    out << "Startup phases (ms):\n";
+    for (const Phase& phase : phases)
+    {
+        out << std::fixed << std::setprecision(2) << std::setw(10) << phase.duration * 1000.0 << "  "
+            << std::string(phase.depth * 2, ' ') << phase.name << '\n';
+    }
+    out << std::defaultfloat;
+}
+
+bool PhaseTimer::writeJson(const vsg::Path& file) const
+{
+    std::ofstream out(file);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "{\n  \"phases\": [\n";
+    for (size_t i = 0; i < phases.size(); ++i)
+    {
+        const Phase& phase = phases[i];
+        out << "    {\"name\": \"" << phase.name << "\", \"depth\": " << phase.depth
+            << ", \"start_ms\": " << phase.start * 1000.0 << ", \"duration_ms\": " << phase.duration * 1000.0 << '}'
+            << (i + 1 < phases.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+
+    return static_cast<bool>(out);
+}
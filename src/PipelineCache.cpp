@@ -0,0 +1,209 @@
+#include "PipelineCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+PipelineCache::PipelineCache(vsg::ref_ptr<vsg::Device> in_device, const vsg::Path& in_file)
+    : device(in_device), file(in_file)
+{
+    std::vector<uint8_t> data;
+
+    std::ifstream input(file, std::ios::binary | std::ios::ate);
+    if (input)
+    {
+        data.resize(static_cast<size_t>(input.tellg()));
+        input.seekg(0);
+        input.read(reinterpret_cast<char*>(data.data()), data.size());
+        if (!input || !validate(data))
+        {
+            vsg::info("PipelineCache: ignoring stale or incompatible ", file);
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (VkResult result = vkCreatePipelineCache(*device, &createInfo, device->getAllocationCallbacks(), &pipelineCache); result != VK_SUCCESS)
+    {
+        throw vsg::Exception{"Error: Failed to create VkPipelineCache.", result};
+    }
+
+    loadedSize = data.size();
+}
+
+PipelineCache::~PipelineCache()
+{
+    if (pipelineCache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(*device, pipelineCache, device->getAllocationCallbacks());
+    }
+}
+
+bool PipelineCache::validate(const std::vector<uint8_t>& data) const
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    const VkPhysicalDeviceProperties& properties = device->getPhysicalDevice()->getProperties();
+
+    return header.headerSize >= sizeof(header)
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+bool PipelineCache::save() const
+{
+    size_t size = 0;
+    if (vkGetPipelineCacheData(*device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(*device, pipelineCache, &size, data.data()) != VK_SUCCESS)
+    {
+        return false;
+    }
+    data.resize(size);
+
+    const vsg::Path temporaryFile = file.string() + ".tmp";
+    {
+        std::ofstream output(temporaryFile, std::ios::binary | std::ios::trunc);
+        if (!output || !output.write(reinterpret_cast<const char*>(data.data()), data.size()))
+        {
+            return false;
+        }
+    }
+
+    return std::rename(temporaryFile.string().c_str(), file.string().c_str()) == 0;
+}
+
+BindCachedGraphicsPipeline::BindCachedGraphicsPipeline(vsg::ref_ptr<vsg::GraphicsPipeline> in_pipeline)
+    : Inherit(0), pipeline(in_pipeline)
+{
+}
+
+BindCachedGraphicsPipeline::~BindCachedGraphicsPipeline()
+{
+    release();
+}
+
+int BindCachedGraphicsPipeline::compare(const vsg::Object& rhs_object) const
+{
+    int result = StateCommand::compare(rhs_object);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    const auto& rhs = static_cast<decltype(*this)>(rhs_object);
+    return vsg::compare_pointer(pipeline, rhs.pipeline);
+}
+
+void BindCachedGraphicsPipeline::compile(vsg::Context& context)
+{
+    std::scoped_lock<std::mutex> lock(compileMutex);
+
+    Compiled& view = compiled[context.viewID];
+    if (view.pipeline != VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vsg::Device* device = context.device;
+
+    // the same preparation vsg::GraphicsPipeline::compile() does before creating its pipeline
+    bool requiresShaderCompiler = false;
+    for (const auto& stage : pipeline->stages)
+    {
+        if (stage->module && stage->module->code.empty() && !stage->module->source.empty())
+        {
+            requiresShaderCompiler = true;
+        }
+    }
+    if (requiresShaderCompiler)
+    {
+        if (auto shaderCompiler = context.getOrCreateShaderCompiler())
+        {
+            shaderCompiler->compile(pipeline->stages);
+        }
+    }
+
+    pipeline->layout->compile(context);
+    for (const auto& stage : pipeline->stages)
+    {
+        stage->compile(context);
+    }
+
+    // view defaults first and view overrides such as the viewport last, as vsg orders them
+    vsg::GraphicsPipelineStates states;
+    states.insert(states.end(), context.defaultPipelineStates.begin(), context.defaultPipelineStates.end());
+    states.insert(states.end(), pipeline->pipelineStates.begin(), pipeline->pipelineStates.end());
+    states.insert(states.end(), context.overridePipelineStates.begin(), context.overridePipelineStates.end());
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.layout = pipeline->layout->vk(device->deviceID);
+    pipelineInfo.renderPass = *context.renderPass;
+    pipelineInfo.subpass = pipeline->subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    std::vector<VkPipelineShaderStageCreateInfo> stageInfos(pipeline->stages.size());
+    for (size_t i = 0; i < stageInfos.size(); ++i)
+    {
+        stageInfos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline->stages[i]->apply(context, stageInfos[i]);
+    }
+    pipelineInfo.stageCount = static_cast<uint32_t>(stageInfos.size());
+    pipelineInfo.pStages = stageInfos.data();
+
+    // the states allocate their create info structs from the context's scratch memory
+    for (const auto& state : states)
+    {
+        state->apply(context, pipelineInfo);
+    }
+
+    const auto* pipelineCache = device->getObject<PipelineCache>(PipelineCache::key);
+    VkResult result = vkCreateGraphicsPipelines(*device, pipelineCache ? pipelineCache->vk() : VK_NULL_HANDLE, 1, &pipelineInfo, device->getAllocationCallbacks(), &view.pipeline);
+    context.scratchMemory->release();
+
+    if (result != VK_SUCCESS)
+    {
+        view.pipeline = VK_NULL_HANDLE;
+        throw vsg::Exception{"Error: BindCachedGraphicsPipeline failed to create VkPipeline.", result};
+    }
+    view.device = device;
+}
+
+void BindCachedGraphicsPipeline::record(vsg::CommandBuffer& commandBuffer) const
+{
+    if (commandBuffer.viewID < compiled.size())
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, compiled[commandBuffer.viewID].pipeline);
+    }
+    commandBuffer.setCurrentPipelineLayout(pipeline->layout);
+}
+
+void BindCachedGraphicsPipeline::release()
+{
+    std::scoped_lock<std::mutex> lock(compileMutex);
+    for (uint32_t viewID = 0; viewID < compiled.size(); ++viewID)
+    {
+        Compiled& view = compiled[viewID];
+        if (view.pipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(*view.device, view.pipeline, view.device->getAllocationCallbacks());
+        }
+        view = {};
+    }
+}
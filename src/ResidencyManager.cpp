@@ -0,0 +1,165 @@
+#include "ResidencyManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+void ResidencyManager::childBytes(const vsg::Node* node, size_t& cpuBytes, size_t& gpuBytes)
+{
+    cpuBytes = 0;
+    gpuBytes = 0;
+    if (node)
+    {
+        // geometry sizes assigned by DMD_Reader when it creates the subgraph
+        node->getValue("cpu_bytes", cpuBytes);
+        node->getValue("gpu_bytes", gpuBytes);
+    }
+}
+
+const vsg::Data* ResidencyManager::childTexture(const vsg::Node* node, size_t& cpuBytes, size_t& gpuBytes)
+{
+    const vsg::Data* texture = node ? node->getObject<vsg::Data>("texture") : nullptr;
+    cpuBytes = texture ? texture->dataSize() : 0;
+    gpuBytes = cpuBytes * 4 / 3; // with mip chain
+    return texture;
+}
+
+void ResidencyManager::update(const std::vector<PagedObject>& objects, const vsg::dvec3& eye, uint64_t frameCount)
+{
+    bool releasedAny = false;
+    while (!released.empty() && frameCount > released.front().frameCount + 4)
+    {
+        released.pop_front();
+        releasedAny = true;
+    }
+
+    // SharedObjects keeps every loaded file, drop the ones no PagedLOD holds any more
+    if (sharedObjects && (releasedAny || frameCount >= lastPruneFrame + 600))
+    {
+        sharedObjects->prune();
+        lastPruneFrame = frameCount;
+    }
+
+    // placements of the same object ref share their subgraph and subgraphs can share a texture, so bytes
+    // are counted once per unique object and only freed when the last placement holding it is evicted
+    struct Shared
+    {
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+        size_t users = 0;
+        const vsg::Data* texture = nullptr;
+    };
+
+    struct Candidate
+    {
+        const PagedObject* object;
+        double score;
+    };
+
+    std::vector<Candidate> candidates;
+    std::unordered_map<const vsg::Object*, Shared> shared;
+
+    numResident = 0;
+    residentCpuBytes = 0;
+    residentGpuBytes = 0;
+
+    for (const PagedObject& object : objects)
+    {
+        vsg::PagedLOD& pagedLod = *object.pagedLod;
+        const vsg::Node* child = pagedLod.children[0].node.get();
+        if (!child)
+        {
+            continue;
+        }
+
+        Shared& subgraph = shared[child];
+        if (subgraph.users++ == 0)
+        {
+            childBytes(child, subgraph.cpuBytes, subgraph.gpuBytes);
+            residentCpuBytes += subgraph.cpuBytes;
+            residentGpuBytes += subgraph.gpuBytes;
+
+            size_t textureCpuBytes, textureGpuBytes;
+            if (auto texture = childTexture(child, textureCpuBytes, textureGpuBytes))
+            {
+                subgraph.texture = texture;
+                Shared& image = shared[texture];
+                if (image.users++ == 0)
+                {
+                    image.cpuBytes = textureCpuBytes;
+                    image.gpuBytes = textureGpuBytes;
+                    residentCpuBytes += textureCpuBytes;
+                    residentGpuBytes += textureGpuBytes;
+                }
+            }
+        }
+
+        ++numResident;
+
+        const uint64_t lastUsed = pagedLod.frameHighResLastUsed;
+        const uint64_t idleFrames = frameCount > lastUsed ? frameCount - lastUsed : 0;
+        if (idleFrames >= minimumIdleFrames && pagedLod.requestStatus == vsg::PagedLOD::NoRequest)
+        {
+            // least recently visible first, scaled up for far and large children
+            size_t cpuBytes, gpuBytes;
+            childBytes(child, cpuBytes, gpuBytes);
+            const double distance = vsg::length(object.center - eye);
+            const double size = static_cast<double>(std::max(cpuBytes, gpuBytes)) + 1.0;
+            const double score = static_cast<double>(idleFrames) * std::log2(2.0 + distance) * std::log2(2.0 + size);
+            candidates.push_back(Candidate{&object, score});
+        }
+    }
+
+    const bool overCpu = cpuBudget > 0 && residentCpuBytes > cpuBudget;
+    const bool overGpu = gpuBudget > 0 && residentGpuBytes > gpuBudget;
+    if (!overCpu && !overGpu)
+    {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) { return lhs.score > rhs.score; });
+
+    auto drop = [&](Shared& entry) {
+        if (--entry.users > 0)
+        {
+            return false;
+        }
+        residentCpuBytes -= entry.cpuBytes;
+        residentGpuBytes -= entry.gpuBytes;
+        evictedBytes += entry.cpuBytes;
+        return true;
+    };
+
+    for (const Candidate& candidate : candidates)
+    {
+        if ((cpuBudget == 0 || residentCpuBytes <= cpuBudget) && (gpuBudget == 0 || residentGpuBytes <= gpuBudget))
+        {
+            break;
+        }
+
+        // expire the child the way the pager does, so its active and inactive lists keep matching the graph
+        vsg::PagedLOD* pagedLod = candidate.object->pagedLod.get();
+        if (databasePager && databasePager->pagedLODContainer)
+        {
+            databasePager->pagedLODContainer->remove(pagedLod);
+        }
+
+        auto& child = pagedLod->children[0];
+        Shared& subgraph = shared[child.node.get()];
+        const size_t evictedBefore = evictedBytes;
+        if (drop(subgraph) && subgraph.texture)
+        {
+            drop(shared[subgraph.texture]);
+        }
+        if (memoryStats)
+        {
+            memoryStats->evicted(evictedBytes - evictedBefore);
+        }
+
+        released.push_back(Released{child.node, frameCount});
+        child.node = {};
+
+        --numResident;
+        ++numEvicted;
+    }
+}
@@ -0,0 +1,204 @@
+#include "Route.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+Route::Route(vsg::ref_ptr<AssetRegistry> in_assets)
+    : assets(in_assets)
+{
+}
+
+bool Route::loadObjectsRef(const std::string& routePath)
+{
+    bool mipmap = false;
+    bool smooth = false;
+    bool occluder = false;
+
+    std::ifstream file(routePath + "/objects.ref");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == ';' || line[0] == ':')
+        {
+            continue;
+        }
+        else if (line == "[mipmap]")
+        {
+            mipmap = true;
+        }
+        else if (line == "[not_mipmap]")
+        {
+            mipmap = false;
+        }
+        else if (line == "[smooth]")
+        {
+            smooth = true;
+        }
+        else if (line == "[not_smooth]")
+        {
+            smooth = false;
+        }
+        else if (line == "[occluder]")
+        {
+            occluder = true;
+        }
+        else if (line == "[not_occluder]")
+        {
+            occluder = false;
+        }
+        else
+        {
+            std::istringstream stream(line);
+            std::string label, modelPath, texturePath;
+            stream >> label >> modelPath >> texturePath;
+
+            ObjectRef objectRef;
+            objectRef.label = label;
+            objectRef.modelId = assets->internModel(routePath + modelPath);
+            objectRef.textureId = assets->internTexture(routePath + texturePath);
+            objectRef.mipmap = mipmap;
+            objectRef.smooth = smooth;
+            objectRef.occluder = occluder;
+
+            // the first definition of a label wins
+            objectRefIds.emplace(label, static_cast<uint32_t>(objectsRef.size()));
+            objectsRef.push_back(objectRef);
+        }
+    }
+
+    return true;
+}
+
+bool Route::loadRouteMap(const std::string& routePath)
+{
+    std::ifstream file(routePath + "/route1.map");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        while (true)
+        {
+            auto CR_pos = line.find('\r');
+            if (CR_pos == std::string::npos)
+            {
+                break;
+            }
+            line.erase(CR_pos);
+        }
+
+        if (line.empty() || line.back() != ';' || line[0] == ',')
+        {
+            continue;
+        }
+        else
+        {
+            line.pop_back();
+            std::replace(line.begin(), line.end(), ',', ' ');
+
+            std::istringstream stream(line);
+            std::string label;
+            vsg::dvec3 translation, rotation;
+            stream >> label >> translation >> rotation;
+
+            rotation.x = vsg::radians(rotation.x);
+            rotation.y = vsg::radians(rotation.y);
+            rotation.z = vsg::radians(rotation.z);
+
+            auto itr = objectRefIds.find(label);
+            if (itr != objectRefIds.end())
+            {
+                ObjectTransformation objectTransformation;
+                objectTransformation.referenceId = itr->second;
+                objectTransformation.translation = translation;
+                objectTransformation.rotation = rotation;
+                objectTransformations.push_back(objectTransformation);
+
+                const ObjectRef& ref = objectsRef[itr->second];
+                assets->addUse(ref.modelId, ref.textureId);
+            }
+        }
+    }
+
+    return true;
+}
+
+vsg::dmat4 Route::placementMatrix(const ObjectTransformation& transformation)
+{
+    const vsg::dvec3& translation = transformation.translation;
+    const vsg::dvec3& rotation = transformation.rotation;
+
+    vsg::dmat4 m1 = vsg::translate(translation);
+    vsg::dmat4 m2 = vsg::rotate(-rotation.z, vsg::dvec3(0.0f, 0.0f, 1.0f));
+    vsg::dmat4 m3 = vsg::rotate(-rotation.x, vsg::dvec3(1.0f, 0.0f, 0.0f));
+    vsg::dmat4 m4 = vsg::rotate(-rotation.y, vsg::dvec3(0.0f, 1.0f, 0.0f));
+
+    return m1 * m2 * m3 * m4;
+}
+
+vsg::dsphere Route::modelSphere(const vsg::box& bounds)
+{
+    return vsg::dsphere(vsg::dvec3((bounds.min + bounds.max) * 0.5f), vsg::length(bounds.max - bounds.min) * 0.5);
+}
+
+vsg::ref_ptr<vsg::Options> Route::createRequestOptions(const ObjectRef& ref, vsg::ref_ptr<const vsg::Options> options)
+{
+    auto request = DMD_Request::create();
+    request->modelId = ref.modelId;
+    request->textureId = ref.textureId;
+    request->mipmap = ref.mipmap;
+    request->smooth = ref.smooth;
+
+    auto requestOptions = vsg::Options::create(*options);
+    requestOptions->setObject(DMD_Request::key, request);
+    return requestOptions;
+}
+
+void Route::createPagedObjects(vsg::ref_ptr<const vsg::Options> options, vsg::Group& sceneGraph, std::vector<PagedObject>& pagedObjects) const
+{
+    // one set of request options per object ref, so placements of the same ref share the loaded subgraph
+    std::vector<vsg::ref_ptr<vsg::Options>> requestOptions(objectsRef.size());
+
+    for (const ObjectTransformation& transformation : objectTransformations)
+    {
+        const ObjectRef& ref = objectsRef[transformation.referenceId];
+
+        auto& pagedOptions = requestOptions[transformation.referenceId];
+        if (!pagedOptions)
+        {
+            pagedOptions = createRequestOptions(ref, options);
+        }
+
+        // the path comes from the request, the short name stays inside the small string buffer
+        auto pagedLod = vsg::PagedLOD::create();
+        pagedLod->options = pagedOptions;
+        pagedLod->filename = vsg::make_string(ref.modelId, ".dmd");
+        pagedLod->children[0].minimumScreenHeightRatio = minimumScreenHeightRatio;
+        vsg::box bounds;
+        pagedLod->bound = assets->modelBounds(ref.modelId, bounds) ? modelSphere(bounds) : vsg::dsphere(vsg::dvec3(0.0, 0.0, 0.0), defaultRadius);
+
+        auto matrixTransform = vsg::MatrixTransform::create();
+        matrixTransform->matrix = placementMatrix(transformation);
+        matrixTransform->addChild(pagedLod);
+
+        sceneGraph.addChild(matrixTransform);
+
+        pagedObjects.push_back(PagedObject{pagedLod, matrixTransform, matrixTransform->matrix * pagedLod->bound.center, pagedLod->bound.radius, ref.modelId, ref.textureId});
+    }
+}
+
+void Route::clear()
+{
+    objectTransformations.clear();
+    objectsRef.clear();
+    objectRefIds.clear();
+}
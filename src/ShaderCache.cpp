@@ -0,0 +1,151 @@
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+// FNV-1a, stable between runs and standard library implementations unlike std::hash
+static void hash_bytes(uint64_t& value, const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        value ^= bytes[i];
+        value *= 0x100000001b3ull;
+    }
+}
+
+static void hash_string(uint64_t& value, const std::string& str)
+{
+    hash_bytes(value, str.data(), str.size());
+    hash_bytes(value, "", 1);
+}
+
+ShaderCache::ShaderCache(const vsg::Path& in_directory)
+    : directory(in_directory)
+{
+}
+
+uint64_t ShaderCache::hash(const vsg::ShaderStage& stage)
+{
+    uint64_t value = 0xcbf29ce484222325ull;
+
+    hash_string(value, VSG_VERSION_STRING);
+    hash_bytes(value, &stage.stage, sizeof(stage.stage));
+    hash_string(value, stage.entryPointName);
+    hash_string(value, stage.module->source);
+
+    if (const auto& hints = stage.module->hints)
+    {
+        hash_bytes(value, &hints->vulkanVersion, sizeof(hints->vulkanVersion));
+        hash_bytes(value, &hints->target, sizeof(hints->target));
+        hash_bytes(value, &hints->generateDebugInfo, sizeof(hints->generateDebugInfo));
+        for (const std::string& define : hints->defines)
+        {
+            hash_string(value, define);
+        }
+    }
+
+    return value;
+}
+
+vsg::Path ShaderCache::cacheFile(const vsg::ShaderStage& stage) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash(stage) << ".spv";
+    return directory / name.str();
+}
+
+bool ShaderCache::load(const vsg::Path& file, vsg::ShaderModule& module) const
+{
+    std::ifstream input(file, std::ios::binary | std::ios::ate);
+    if (!input)
+    {
+        return false;
+    }
+
+    const std::streamsize size = input.tellg();
+    if (size <= 0 || size % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+
+    vsg::ShaderModule::SPIRV code(size / sizeof(uint32_t));
+    input.seekg(0);
+    if (!input.read(reinterpret_cast<char*>(code.data()), size))
+    {
+        return false;
+    }
+
+    // SPIR-V magic number
+    if (code[0] != 0x07230203)
+    {
+        return false;
+    }
+
+    module.code = std::move(code);
+    return true;
+}
+
+bool ShaderCache::store(const vsg::Path& file, const vsg::ShaderModule& module) const
+{
+    // write to a temporary file first so an interrupted run can't leave a truncated entry
+    const vsg::Path temporaryFile = file.string() + ".tmp";
+    {
+        std::ofstream output(temporaryFile, std::ios::binary | std::ios::trunc);
+        if (!output || !output.write(reinterpret_cast<const char*>(module.code.data()), module.code.size() * sizeof(uint32_t)))
+        {
+            return false;
+        }
+    }
+
+    return std::rename(temporaryFile.string().c_str(), file.string().c_str()) == 0;
+}
+
+bool ShaderCache::apply(const vsg::ShaderStages& stages, vsg::ref_ptr<const vsg::Options> options)
+{
+    vsg::ShaderStages missing;
+    std::set<const vsg::ShaderModule*> visited;
+    for (const auto& stage : stages)
+    {
+        if (!stage || !stage->module || !stage->module->code.empty() || !visited.insert(stage->module.get()).second)
+        {
+            continue;
+        }
+
+        if (load(cacheFile(*stage), *stage->module))
+        {
+            ++hits;
+        }
+        else
+        {
+            ++misses;
+            missing.push_back(stage);
+        }
+    }
+
+    if (missing.empty())
+    {
+        return true;
+    }
+
+    auto compiler = vsg::ShaderCompiler::create();
+    if (!compiler->compile(missing, {}, options))
+    {
+        vsg::warn("ShaderCache: failed to compile ", missing.size(), " shader stages");
+        return false;
+    }
+
+    vsg::makeDirectory(directory);
+    for (const auto& stage : missing)
+    {
+        if (!stage->module->code.empty() && !store(cacheFile(*stage), *stage->module))
+        {
+            vsg::warn("ShaderCache: failed to write ", cacheFile(*stage));
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,173 @@
+#include "TextureAtlas.h"
+
+#include "ImageLoader.h"
+
+#include <algorithm>
+#include <fstream>
+
+void TextureAtlas::build(std::vector<vsg::Path> texturePaths)
+{
+    placements.clear();
+    regions.clear();
+    pages.clear();
+
+    // sort the input so that the same route always produces the same atlas
+    std::sort(texturePaths.begin(), texturePaths.end());
+    texturePaths.erase(std::unique(texturePaths.begin(), texturePaths.end()), texturePaths.end());
+
+    const int maxSize = static_cast<int>(std::min(maxTextureSize, pageSize - 2 * padding));
+    for (const vsg::Path& path : texturePaths)
+    {
+        Placement placement{path, 0, 0, 0, 0, 0};
+        if (!readImageSize(path, placement.width, placement.height))
+        {
+            continue;
+        }
+
+        if (placement.width <= maxSize && placement.height <= maxSize)
+        {
+            placements.push_back(placement);
+        }
+    }
+
+    std::stable_sort(placements.begin(), placements.end(), [](const Placement& lhs, const Placement& rhs) {
+        return lhs.height > rhs.height;
+    });
+
+    // slots start on multiples of the coarsest usable mip texel, so no texel of those levels spans two slots
+    const uint32_t alignment = 1u << static_cast<uint32_t>(maxLod());
+    auto aligned = [alignment](uint32_t size) { return (size + alignment - 1) & ~(alignment - 1); };
+
+    // shelf packing, textures are sorted by height so every shelf wastes little space
+    uint32_t page = 0;
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t shelfHeight = 0;
+    for (Placement& placement : placements)
+    {
+        const uint32_t width = aligned(placement.width + 2 * padding);
+        const uint32_t height = aligned(placement.height + 2 * padding);
+
+        if (x + width > pageSize)
+        {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+
+        if (y + height > pageSize)
+        {
+            ++page;
+            x = 0;
+            y = 0;
+            shelfHeight = 0;
+        }
+
+        placement.page = page;
+        placement.x = x + padding;
+        placement.y = y + padding;
+
+        x += width;
+        shelfHeight = std::max(shelfHeight, height);
+    }
+
+    if (!placements.empty())
+    {
+        pages.resize(page + 1);
+        for (auto& atlasPage : pages)
+        {
+            atlasPage = vsg::ubvec4Array2D::create(pageSize, pageSize, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+            std::fill(atlasPage->begin(), atlasPage->end(), vsg::ubvec4(0, 0, 0, 0));
+        }
+    }
+
+    const float invPageSize = 1.0f / static_cast<float>(pageSize);
+    for (const Placement& placement : placements)
+    {
+        auto image = loadImage(placement.path);
+        if (!image || static_cast<int>(image->width()) != placement.width || static_cast<int>(image->height()) != placement.height)
+        {
+            continue;
+        }
+
+        copyToPage(placement, *image);
+
+        AtlasRegion region;
+        region.page = placement.page;
+        region.offset.set(placement.x * invPageSize, placement.y * invPageSize);
+        region.scale.set(placement.width * invPageSize, placement.height * invPageSize);
+        regions[placement.path] = region;
+    }
+
+    for (auto& atlasPage : pages)
+    {
+        atlasPage->setValue("transparent", hasTransparency(*atlasPage));
+    }
+}
+
+void TextureAtlas::copyToPage(const Placement& placement, const vsg::ubvec4Array2D& image)
+{
+    vsg::ubvec4Array2D& target = *pages[placement.page];
+
+    // the padding repeats the border texels to avoid bleeding between neighbours when filtering
+    const int pad = static_cast<int>(padding);
+    for (int row = -pad; row < placement.height + pad; ++row)
+    {
+        const int sourceRow = std::clamp(row, 0, placement.height - 1);
+        for (int column = -pad; column < placement.width + pad; ++column)
+        {
+            const int sourceColumn = std::clamp(column, 0, placement.width - 1);
+            target.at(placement.x + column, placement.y + row) = image.at(sourceColumn, sourceRow);
+        }
+    }
+}
+
+bool TextureAtlas::writeIndex(const vsg::Path& indexFile) const
+{
+    std::ofstream file(indexFile);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "; page_size " << pageSize << " padding " << padding << " pages " << pages.size() << '\n';
+    file << "; page x y width height texture\n";
+
+    std::vector<Placement> sorted(placements);
+    std::sort(sorted.begin(), sorted.end(), [](const Placement& lhs, const Placement& rhs) {
+        return lhs.path < rhs.path;
+    });
+
+    for (const Placement& placement : sorted)
+    {
+        if (regions.count(placement.path) != 0)
+        {
+            file << placement.page << ' ' << placement.x << ' ' << placement.y << ' '
+                 << placement.width << ' ' << placement.height << ' ' << placement.path << '\n';
+        }
+    }
+
+    return true;
+}
+
+float TextureAtlas::maxLod() const
+{
+    // at least one texel of padding has to remain at the coarsest level
+    float lod = 0.0f;
+    for (uint32_t remaining = padding; remaining >= 2; remaining /= 2)
+    {
+        lod += 1.0f;
+    }
+    return lod;
+}
+
+const AtlasRegion* TextureAtlas::find(const vsg::Path& texturePath) const
+{
+    auto itr = regions.find(texturePath);
+    return itr != regions.end() ? &itr->second : nullptr;
+}
+
+vsg::ref_ptr<vsg::Data> TextureAtlas::page(uint32_t index) const
+{
+    return index < pages.size() ? pages[index] : vsg::ref_ptr<vsg::ubvec4Array2D>();
+}
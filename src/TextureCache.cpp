@@ -0,0 +1,285 @@
+#include "TextureCache.h"
+
+#include "ImageLoader.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+static vsg::ref_ptr<vsg::ubvec4Array2D> halve(const vsg::ubvec4Array2D& image)
+{
+    const uint32_t width = std::max(image.width() / 2, 1u);
+    const uint32_t height = std::max(image.height() / 2, 1u);
+
+    auto result = vsg::ubvec4Array2D::create(width, height, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+    for (uint32_t j = 0; j < height; ++j)
+    {
+        const uint32_t j0 = std::min(j * 2, image.height() - 1);
+        const uint32_t j1 = std::min(j * 2 + 1, image.height() - 1);
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            const uint32_t i0 = std::min(i * 2, image.width() - 1);
+            const uint32_t i1 = std::min(i * 2 + 1, image.width() - 1);
+
+            const vsg::ubvec4& a = image.at(i0, j0);
+            const vsg::ubvec4& b = image.at(i1, j0);
+            const vsg::ubvec4& c = image.at(i0, j1);
+            const vsg::ubvec4& d = image.at(i1, j1);
+
+            vsg::ubvec4& texel = result->at(i, j);
+            for (int k = 0; k < 4; ++k)
+            {
+                texel[k] = static_cast<uint8_t>((a[k] + b[k] + c[k] + d[k] + 2) / 4);
+            }
+        }
+    }
+
+    bool transparent = true;
+    image.getValue("transparent", transparent);
+    result->setValue("transparent", transparent);
+
+    return result;
+}
+
+size_t TextureCache::estimateBytes(uint32_t width, uint32_t height)
+{
+    // RGBA8 with a full mip chain
+    return static_cast<size_t>(width) * height * 4 * 4 / 3;
+}
+
+vsg::ref_ptr<vsg::Data> TextureCache::createPlaceholder()
+{
+    auto image = vsg::ubvec4Array2D::create(2, 2, vsg::Data::Properties{VK_FORMAT_R8G8B8A8_UNORM});
+    std::fill(image->begin(), image->end(), vsg::ubvec4(255, 0, 255, 255));
+    image->setValue("transparent", false);
+    return image;
+}
+
+vsg::ref_ptr<vsg::ubvec4Array2D> TextureCache::decode(const vsg::Path& file, uint32_t& width, uint32_t& height) const
+{
+    TRACE_SCOPE("texture decode");
+
+    auto image = loadImage(file);
+    if (!image)
+    {
+        return {};
+    }
+
+    width = image->width();
+    height = image->height();
+
+    if (maxDimension > 0)
+    {
+        while (std::max(image->width(), image->height()) > maxDimension)
+        {
+            image = halve(*image);
+        }
+    }
+
+    return image;
+}
+
+vsg::ref_ptr<vsg::Data> TextureCache::load(uint32_t textureId, const vsg::Path& file)
+{
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        if (textureId >= entries.size())
+        {
+            entries.resize(textureId + 1);
+        }
+
+        Entry& entry = entries[textureId];
+        if (entry.failed)
+        {
+            return {};
+        }
+
+        if (entry.image)
+        {
+            entry.lastUsedFrame = std::max<uint64_t>(entry.lastUsedFrame, frameCount);
+
+            // a reduced texture is reloaded at full resolution once the budget allows it again, but not while
+            // the scene graph still holds the reduced image, replacing it then wouldn't free its memory
+            const bool reload = entry.reduction > 0 && budget > 0 && !inUse(entry) &&
+                                totalBytes - entry.bytes + estimateBytes(entry.width, entry.height) <= budget;
+            if (!reload)
+            {
+                return entry.image;
+            }
+        }
+    }
+
+    uint32_t width = 0, height = 0;
+    auto image = decode(file, width, height);
+
+    std::scoped_lock<std::mutex> lock(mutex);
+    Entry& entry = entries[textureId];
+    if (!image)
+    {
+        // a failed reload keeps the reduced image
+        if (entry.image)
+        {
+            return entry.image;
+        }
+        entry.failed = true;
+        return {};
+    }
+
+    if (entry.image && (entry.reduction == 0 || inUse(entry)))
+    {
+        // another reader decoded this texture meanwhile, or the scene graph picked up the reduced image, keep that one
+        return entry.image;
+    }
+
+    totalBytes -= entry.bytes;
+
+    entry.file = file;
+    entry.image = image;
+    entry.width = width;
+    entry.height = height;
+    entry.reduction = 0;
+    entry.bytes = estimateBytes(image->width(), image->height());
+    entry.lastUsedFrame = std::max<uint64_t>(entry.lastUsedFrame, frameCount + freshFrames);
+    entry.lastResidentFrame = std::max<uint64_t>(entry.lastResidentFrame, frameCount + freshFrames);
+
+    if (budget > 0)
+    {
+        makeRoom(entry.bytes, textureId);
+        while (totalBytes + entry.bytes > budget && entry.reduction < maxReduction && entry.image->width() > 1 && entry.image->height() > 1)
+        {
+            reduce(entry);
+        }
+    }
+
+    totalBytes += entry.bytes;
+
+    return entry.image;
+}
+
+bool TextureCache::contains(uint32_t textureId) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return textureId < entries.size() && (entries[textureId].image || entries[textureId].failed);
+}
+
+void TextureCache::markVisible(const std::vector<uint32_t>& textureIds, uint64_t frame)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    for (uint32_t textureId : textureIds)
+    {
+        if (textureId < entries.size())
+        {
+            Entry& entry = entries[textureId];
+            entry.lastUsedFrame = std::max(entry.lastUsedFrame, frame);
+        }
+    }
+}
+
+void TextureCache::markResident(const std::vector<uint32_t>& textureIds, uint64_t frame)
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    for (uint32_t textureId : textureIds)
+    {
+        if (textureId < entries.size())
+        {
+            Entry& entry = entries[textureId];
+            entry.lastResidentFrame = std::max(entry.lastResidentFrame, frame);
+        }
+    }
+}
+
+void TextureCache::reduce(Entry& entry)
+{
+    entry.image = halve(*entry.image);
+    entry.bytes = estimateBytes(entry.image->width(), entry.image->height());
+    ++entry.reduction;
+}
+
+void TextureCache::makeRoom(size_t bytes, uint32_t keep)
+{
+    std::vector<Entry*> candidates;
+    for (uint32_t textureId = 0; textureId < entries.size(); ++textureId)
+    {
+        // textures still referenced by the scene graph can't be changed
+        Entry& entry = entries[textureId];
+        if (textureId != keep && entry.image && !inUse(entry))
+        {
+            candidates.push_back(&entry);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Entry* lhs, const Entry* rhs) {
+        return lhs->lastUsedFrame < rhs->lastUsedFrame;
+    });
+
+    // first drop the top mip level of the least recently used textures, then release them
+    for (int pass = 0; pass < 2 && totalBytes + bytes > budget; ++pass)
+    {
+        for (Entry* candidate : candidates)
+        {
+            if (totalBytes + bytes <= budget)
+            {
+                break;
+            }
+
+            Entry& entry = *candidate;
+            if (!entry.image)
+            {
+                continue;
+            }
+
+            totalBytes -= entry.bytes;
+            if (pass == 0 && entry.reduction < maxReduction && entry.image->width() > 1 && entry.image->height() > 1)
+            {
+                reduce(entry);
+                totalBytes += entry.bytes;
+            }
+            else if (pass == 1)
+            {
+                entry.image = {};
+                entry.bytes = 0;
+                entry.reduction = 0;
+            }
+            else
+            {
+                totalBytes += entry.bytes;
+            }
+        }
+    }
+}
+
+size_t TextureCache::residentBytes() const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return totalBytes;
+}
+
+void TextureCache::report(std::ostream& out) const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+
+    const size_t numResident = std::count_if(entries.begin(), entries.end(), [](const Entry& entry) { return entry.image.valid(); });
+    const size_t numFailed = std::count_if(entries.begin(), entries.end(), [](const Entry& entry) { return entry.failed; });
+
+    out << "Texture residency: " << numResident << " textures, " << numFailed << " failed, " << (totalBytes / 1024) << " KiB";
+    if (budget > 0)
+    {
+        out << " of " << (budget / 1024) << " KiB budget";
+    }
+    out << '\n';
+
+    for (const Entry& entry : entries)
+    {
+        if (!entry.image)
+        {
+            continue;
+        }
+
+        out << std::setw(6) << entry.image->width() << 'x' << std::left << std::setw(6) << entry.image->height() << std::right
+            << " of " << std::setw(5) << entry.width << 'x' << std::left << std::setw(6) << entry.height << std::right
+            << " -" << entry.reduction << " mips " << std::setw(8) << (entry.bytes / 1024) << " KiB"
+            << " frame " << std::setw(8) << entry.lastUsedFrame
+            << (inUse(entry) ? " in use " : " cached ") << entry.file << '\n';
+    }
+}
@@ -0,0 +1,130 @@
+#include "TextureDecodePool.h"
+
+#include "Trace.h"
+
+#include <algorithm>
+
+TextureDecodePool::TextureDecodePool(vsg::ref_ptr<TextureCache> in_textureCache, uint32_t numThreads)
+    : textureCache(in_textureCache)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back([this]() { run(); });
+    }
+}
+
+TextureDecodePool::~TextureDecodePool()
+{
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        done = true;
+    }
+    condition.notify_all();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void TextureDecodePool::request(uint32_t textureId, const vsg::Path& file)
+{
+    if (textureCache->contains(textureId))
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        if (!tasks.emplace(textureId, std::make_shared<Task>()).second)
+        {
+            return;
+        }
+        queue.emplace_back(textureId, file);
+    }
+    condition.notify_one();
+}
+
+vsg::ref_ptr<vsg::Data> TextureDecodePool::acquire(uint32_t textureId, const vsg::Path& file)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto& task = tasks[textureId];
+    if (!task)
+    {
+        task = std::make_shared<Task>();
+    }
+    else if (task->started)
+    {
+        // another thread is decoding the same texture, share its result
+        auto future = task->future;
+        lock.unlock();
+        return future.get();
+    }
+
+    // not started yet, decode it on the calling thread rather than wait for the queue
+    auto ownTask = task;
+    ownTask->started = true;
+    lock.unlock();
+
+    return decode(textureId, file, ownTask);
+}
+
+vsg::ref_ptr<vsg::Data> TextureDecodePool::decode(uint32_t textureId, const vsg::Path& file, const std::shared_ptr<Task>& task)
+{
+    auto data = textureCache->load(textureId, file);
+    task->promise.set_value(data);
+
+    std::scoped_lock<std::mutex> lock(mutex);
+    auto itr = tasks.find(textureId);
+    if (itr != tasks.end() && itr->second == task)
+    {
+        tasks.erase(itr);
+    }
+
+    return data;
+}
+
+void TextureDecodePool::run()
+{
+    if (Trace::enabled())
+    {
+        Trace::nameThread("texture decode");
+    }
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() { return done || !queue.empty(); });
+        if (done)
+        {
+            return;
+        }
+
+        auto [textureId, file] = queue.front();
+        queue.pop_front();
+
+        auto itr = tasks.find(textureId);
+        if (itr == tasks.end() || itr->second->started)
+        {
+            continue;
+        }
+
+        auto task = itr->second;
+        task->started = true;
+        lock.unlock();
+
+        decode(textureId, file, task);
+    }
+}
+
+size_t TextureDecodePool::pending() const
+{
+    std::scoped_lock<std::mutex> lock(mutex);
+    return tasks.size();
+}
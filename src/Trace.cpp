@@ -0,0 +1,130 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic_bool Trace::active{false};
+
+struct TraceEvent
+{
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+struct TraceBuffer
+{
+    uint32_t id = 0;
+    const char* name = nullptr;
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+};
+
+// buffers outlive their threads, pager threads are gone by the time the trace is written
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+};
+
+static TraceRegistry& registry()
+{
+    static TraceRegistry instance;
+    return instance;
+}
+
+static TraceBuffer& threadBuffer()
+{
+    thread_local std::shared_ptr<TraceBuffer> buffer = []() {
+        auto created = std::make_shared<TraceBuffer>();
+        TraceRegistry& reg = registry();
+        std::scoped_lock<std::mutex> lock(reg.mutex);
+        created->id = static_cast<uint32_t>(reg.buffers.size() + 1);
+        reg.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+static void writeString(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            out << '\\';
+        }
+        out << *str;
+    }
+    out << '"';
+}
+
+void Trace::nameThread(const char* name)
+{
+    TraceBuffer& buffer = threadBuffer();
+    std::scoped_lock<std::mutex> lock(buffer.mutex);
+    if (!buffer.name)
+    {
+        buffer.name = name;
+    }
+}
+
+void Trace::record(const char* name, int64_t start, int64_t end)
+{
+    TraceBuffer& buffer = threadBuffer();
+    std::scoped_lock<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(TraceEvent{name, start, end});
+}
+
+bool Trace::write(const vsg::Path& file)
+{
+    std::ofstream out(file);
+    if (!out)
+    {
+        return false;
+    }
+
+    TraceRegistry& reg = registry();
+    std::scoped_lock<std::mutex> registryLock(reg.mutex);
+
+    // timestamps relative to the earliest event, in microseconds
+    int64_t origin = INT64_MAX;
+    for (auto& buffer : reg.buffers)
+    {
+        std::scoped_lock<std::mutex> lock(buffer->mutex);
+        for (const TraceEvent& event : buffer->events)
+        {
+            origin = std::min(origin, event.start);
+        }
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto& buffer : reg.buffers)
+    {
+        std::scoped_lock<std::mutex> lock(buffer->mutex);
+
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+        writeString(out, buffer->name ? buffer->name : "worker");
+        out << "}}";
+        first = false;
+
+        for (const TraceEvent& event : buffer->events)
+        {
+            out << ",\n{\"name\":";
+            writeString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":" << (event.start - origin) / 1000.0
+                << ",\"dur\":" << (event.end - event.start) / 1000.0 << '}';
+        }
+    }
+    out << "\n]}\n";
+
+    return static_cast<bool>(out);
+}
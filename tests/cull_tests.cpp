@@ -0,0 +1,259 @@
+// CPU checks of the frustum and occlusion culling, no window or Vulkan device needed.
+//
+//   cull_tests
+
+#include "DMD_Writer.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "Route.h"
+
+#include <vsg/all.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << what << '\n';
+        ++failures;
+    }
+}
+
+// planes that accept everything, so a test can constrain just one of the six
+static void openPlanes(float (*planes)[4])
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        planes[i][0] = planes[i][1] = planes[i][2] = 0.0f;
+        planes[i][3] = 1.0f;
+    }
+}
+
+static void testScalarMatchesAvx2()
+{
+    if (!FrustumCuller::avx2Supported())
+    {
+        std::cout << "scalar/avx2: skipped, no AVX2 kernel on this build or CPU\n";
+        return;
+    }
+
+    // a count that isn't a multiple of eight, padded to 64 like FrustumCuller::build does
+    const size_t count = 10007;
+    const size_t padded = (count + 63) & ~size_t(63);
+    std::vector<float> x(padded, 0.0f), y(padded, 0.0f), z(padded, 0.0f), r(padded, -FLT_MAX);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.0f, 50.0f);
+    for (size_t i = 0; i < count; ++i)
+    {
+        x[i] = position(random);
+        y[i] = position(random);
+        z[i] = position(random);
+        r[i] = size(random);
+    }
+
+    for (int frustum = 0; frustum < 16; ++frustum)
+    {
+        const double heading = frustum * vsg::PI / 8.0;
+        const vsg::dvec3 eye(position(random), position(random), 0.0);
+        const vsg::dmat4 projectionView = vsg::perspective(vsg::radians(60.0), 1.25, 1.0, 800.0) * vsg::lookAt(eye, eye + vsg::dvec3(std::cos(heading), std::sin(heading), -0.1), vsg::dvec3(0.0, 0.0, 1.0));
+        const FrustumCuller::Planes planes = FrustumCuller::frustumPlanes(projectionView);
+
+        float floatPlanes[6][4];
+        for (int i = 0; i < 6; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                floatPlanes[i][j] = static_cast<float>(planes[i][j]);
+            }
+        }
+
+        std::vector<uint64_t> scalarBits(padded / 64, ~uint64_t(0)), avx2Bits(padded / 64, ~uint64_t(0));
+        cull_spheres_scalar(x.data(), y.data(), z.data(), r.data(), padded, floatPlanes, scalarBits.data());
+        cull_spheres_avx2(x.data(), y.data(), z.data(), r.data(), padded, floatPlanes, avx2Bits.data());
+        check(scalarBits == avx2Bits, "scalar and avx2 kernels produce identical bits");
+    }
+}
+
+static void testKnownPlanes()
+{
+    // spheres of radius 0.5 at x = 0..99 against the plane x <= 50.25: the sphere at 50 reaches past it,
+    // the one at 51 lies 0.75 beyond it and is outside
+    const size_t count = 100;
+    const size_t padded = 128;
+    std::vector<float> x(padded, 0.0f), y(padded, 0.0f), z(padded, 0.0f), r(padded, -FLT_MAX);
+    for (size_t i = 0; i < count; ++i)
+    {
+        x[i] = static_cast<float>(i);
+        r[i] = 0.5f;
+    }
+
+    float planes[6][4];
+    openPlanes(planes);
+    planes[0][0] = -1.0f;
+    planes[0][3] = 50.25f;
+
+    std::vector<uint64_t> expected(2, 0);
+    expected[0] = ~uint64_t(0) >> (63 - 50); // bits 0..50
+
+    for (bool avx2 : {false, true})
+    {
+        if (avx2 && !FrustumCuller::avx2Supported())
+        {
+            continue;
+        }
+
+        std::vector<uint64_t> bits(2, ~uint64_t(0));
+        (avx2 ? cull_spheres_avx2 : cull_spheres_scalar)(x.data(), y.data(), z.data(), r.data(), padded, planes, bits.data());
+        check(bits == expected, avx2 ? "avx2 kernel gives the expected bits and a clear padded tail" : "scalar kernel gives the expected bits and a clear padded tail");
+    }
+
+    // the same setup through FrustumCuller, which stores the spheres relative to their centre
+    std::vector<vsg::dsphere> spheres;
+    for (size_t i = 0; i < count; ++i)
+    {
+        spheres.emplace_back(vsg::dvec3(1000.0 + static_cast<double>(i), 0.0, 0.0), 0.5);
+    }
+
+    FrustumCuller::Planes open;
+    open.fill(vsg::dvec4(0.0, 0.0, 0.0, 1.0));
+    FrustumCuller::Planes limited = open;
+    limited[0] = vsg::dvec4(-1.0, 0.0, 0.0, 1050.25);
+
+    auto culler = FrustumCuller::create();
+    culler->build(spheres);
+    check(culler->size() == count, "FrustumCuller keeps the sphere count");
+    check(culler->cull(open) == count, "open planes keep every sphere");
+    check(culler->cull(limited) == 51, "the plane keeps spheres 0..50");
+    check(culler->bits() == expected, "FrustumCuller gives the expected bits and a clear padded tail");
+    check(culler->visible(50) && !culler->visible(51), "the sphere at the plane is visible, the next one isn't");
+    check(culler->cull(limited, 1.0) == 52, "a margin of one widens the plane by one sphere");
+}
+
+static void testShadowCasterPlanes()
+{
+    // looking along +x with the sun straight overhead, shadows drawn up to 200 units away
+    const vsg::dvec3 eye(0.0, 0.0, 0.0);
+    const vsg::dmat4 projectionView = vsg::perspective(vsg::radians(60.0), 1.0, 1.0, 1000.0) * vsg::lookAt(eye, vsg::dvec3(1.0, 0.0, 0.0), vsg::dvec3(0.0, 0.0, 1.0));
+    const FrustumCuller::Planes planes = FrustumCuller::shadowCasterPlanes(FrustumCuller::frustumPlanes(projectionView), eye, 200.0, vsg::dvec3(0.0, 0.0, -1.0));
+
+    std::vector<vsg::dsphere> spheres{
+        vsg::dsphere(50.0, 0.0, 0.0, 1.0),    // in view
+        vsg::dsphere(50.0, 0.0, 200.0, 1.0),  // above the view, casts into it
+        vsg::dsphere(-50.0, 0.0, 200.0, 1.0), // above and behind the camera
+        vsg::dsphere(50.0, 0.0, -200.0, 1.0), // below the view
+        vsg::dsphere(300.0, 0.0, 0.0, 1.0),   // in view beyond the shadow distance
+    };
+
+    auto culler = FrustumCuller::create();
+    culler->build(spheres);
+    std::vector<uint64_t> bits;
+    culler->cull(planes, bits);
+    check(bits.size() == 1 && bits[0] == 0b00011, "the shadow volume keeps the spheres in view and above it, within the shadow distance");
+}
+
+static void testOccluderQuad()
+{
+    // a 20 x 20 wall 50 units in front of the camera, as two triangles
+    auto triangles = vsg::vec3Array::create(6);
+    (*triangles)[0] = vsg::vec3(-10.0f, -10.0f, -50.0f);
+    (*triangles)[1] = vsg::vec3(10.0f, -10.0f, -50.0f);
+    (*triangles)[2] = vsg::vec3(10.0f, 10.0f, -50.0f);
+    (*triangles)[3] = vsg::vec3(-10.0f, -10.0f, -50.0f);
+    (*triangles)[4] = vsg::vec3(10.0f, 10.0f, -50.0f);
+    (*triangles)[5] = vsg::vec3(-10.0f, 10.0f, -50.0f);
+
+    std::vector<Occluder> occluders(1);
+    occluders[0].triangles = triangles;
+    occluders[0].bound = vsg::dsphere(0.0, 0.0, -50.0, 15.0);
+
+    const vsg::dvec3 eye(0.0, 0.0, 0.0);
+    const vsg::dmat4 projectionView = vsg::perspective(vsg::radians(90.0), 2.0, 1.0, 1000.0) * vsg::lookAt(eye, vsg::dvec3(0.0, 0.0, -1.0), vsg::dvec3(0.0, 1.0, 0.0));
+
+    auto culler = OcclusionCuller::create(256, 128);
+    culler->render(occluders, projectionView, eye);
+    check(culler->numOccluders == 1 && culler->numTriangles == 2, "the wall is rasterized");
+
+    check(culler->occluded(vsg::dsphere(0.0, 0.0, -100.0, 2.0)), "a sphere behind the wall is occluded");
+    check(!culler->occluded(vsg::dsphere(40.0, 0.0, -100.0, 2.0)), "a sphere beside the wall is visible");
+    check(!culler->occluded(vsg::dsphere(0.0, 0.0, -20.0, 2.0)), "a sphere in front of the wall is visible");
+    check(!culler->occluded(vsg::dsphere(0.0, 0.0, -100.0, 50.0)), "a sphere larger than the wall is visible");
+
+    // the wall's edge projects to x = 20 at a distance of 100, spheres reaching past it by less than a buffer
+    // pixel stay visible wherever the edge falls within a pixel
+    bool edgeVisible = true;
+    for (double x = 18.0; x < 21.0; x += 0.01)
+    {
+        if (x + 1.0 > 20.0 && culler->occluded(vsg::dsphere(x, 0.0, -100.0, 1.0)))
+        {
+            edgeVisible = false;
+        }
+    }
+    check(edgeVisible, "a sphere showing past the wall's edge is visible");
+}
+
+// a flat grey size x size 32 bit TGA, opaque or with every other texel transparent
+static void writeTexture(const std::filesystem::path& file, uint8_t size, bool holes)
+{
+    std::ofstream out(file, std::ios::binary);
+    const char header[18] = {0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, static_cast<char>(size), 0, static_cast<char>(size), 0, 32, 8};
+    out.write(header, sizeof(header));
+    for (uint32_t i = 0; i < static_cast<uint32_t>(size) * size; ++i)
+    {
+        const char texel[4] = {static_cast<char>(128), static_cast<char>(128), static_cast<char>(128), static_cast<char>(holes && (i % 2) == 0 ? 0 : 255)};
+        out.write(texel, sizeof(texel));
+    }
+}
+
+static void testTransparentOccluder()
+{
+    // the same 20 x 20 wall marked [occluder] twice, once with an opaque texture and once with a fence texture
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "cull_tests";
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path model = directory / "wall.dmd";
+    dmd_write(vsg::Path(model.string()), dmd_grid(1, 1, 20.0f));
+    writeTexture(directory / "solid.tga", 8, false);
+    writeTexture(directory / "fence.tga", 8, true);
+
+    auto assets = AssetRegistry::create();
+    auto route = Route::create(assets);
+    const uint32_t modelId = assets->internModel(model.string());
+    route->objectsRef.push_back(ObjectRef{"wall", modelId, assets->internTexture((directory / "solid.tga").string()), true, true, true});
+    route->objectsRef.push_back(ObjectRef{"fence", modelId, assets->internTexture((directory / "fence.tga").string()), true, true, true});
+    route->objectTransformations.push_back(ObjectTransformation{0, vsg::dvec3(0.0, 0.0, 0.0), vsg::dvec3()});
+    route->objectTransformations.push_back(ObjectTransformation{1, vsg::dvec3(100.0, 0.0, 0.0), vsg::dvec3()});
+
+    const std::vector<Occluder> occluders = OcclusionCuller::createOccluders(*route, vsg::Options::create(), 0.0, 64);
+    check(occluders.size() == 1 && std::abs(occluders[0].bound.center.x) < 1.0, "the opaque wall is an occluder, the alpha tested fence isn't");
+
+    std::filesystem::remove_all(directory);
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    testScalarMatchesAvx2();
+    testKnownPlanes();
+    testShadowCasterPlanes();
+    testOccluderQuad();
+    testTransparentOccluder();
+
+    if (failures != 0)
+    {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+
+    std::cout << "all checks passed\n";
+    return 0;
+}
@@ -0,0 +1,93 @@
+// CPU checks of the texture budget, no window or Vulkan device needed.
+//
+//   texture_cache_tests
+
+#include "TextureCache.h"
+
+#include <vsg/all.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << what << '\n';
+        ++failures;
+    }
+}
+
+// a flat grey size x size binary PPM, which stb_image decodes
+static vsg::Path writeImage(const std::filesystem::path& directory, uint32_t index, uint32_t size)
+{
+    const std::filesystem::path file = directory / ("texture" + std::to_string(index) + ".ppm");
+    std::ofstream out(file, std::ios::binary);
+    out << "P6\n" << size << ' ' << size << "\n255\n";
+    const std::vector<char> pixels(static_cast<size_t>(size) * size * 3, static_cast<char>(index * 20));
+    out.write(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+    return vsg::Path(file.string());
+}
+
+static void testBudgetWithBoundTextures()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "texture_cache_tests";
+    std::filesystem::create_directories(directory);
+
+    const uint32_t size = 64;
+    std::vector<vsg::Path> files;
+    for (uint32_t index = 0; index < 5; ++index)
+    {
+        files.push_back(writeImage(directory, index, size));
+    }
+
+    const size_t textureBytes = TextureCache::estimateBytes(size, size);
+    auto cache = TextureCache::create();
+    cache->budget = textureBytes * 3;
+    cache->freshFrames = 0;
+    cache->releaseFrames = 2;
+
+    // three textures bound by loaded placements, the descriptors hold their images like the reader's do
+    auto sampler = vsg::Sampler::create();
+    std::vector<vsg::ref_ptr<vsg::DescriptorImage>> bound;
+    cache->frameCount = 1;
+    for (uint32_t textureId = 0; textureId < 3; ++textureId)
+    {
+        auto image = cache->load(textureId, files[textureId]);
+        check(image && image->width() == size, "a texture inside the budget loads at full resolution");
+        bound.push_back(vsg::DescriptorImage::create(sampler, image, 0, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER));
+    }
+    cache->markResident({0, 1, 2}, 1);
+    check(cache->residentBytes() == 3 * textureBytes, "the three textures fill the budget");
+
+    // the placements of textures 1 and 2 unloaded, their descriptors still exist
+    cache->frameCount = 10;
+    cache->markResident({0}, 10);
+    auto first = cache->load(0, files[0]);
+    cache->load(3, files[3]);
+    cache->load(4, files[4]);
+
+    check(cache->residentBytes() <= cache->budget, "the budget holds while unloaded textures are still bound");
+    check(!cache->contains(1) && !cache->contains(2), "textures only descriptors hold are reduced, then dropped");
+    check(cache->load(0, files[0]) == first && first->width() == size, "a texture a loaded placement holds keeps its resolution");
+
+    std::filesystem::remove_all(directory);
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+    testBudgetWithBoundTextures();
+
+    if (failures != 0)
+    {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+
+    std::cout << "all checks passed\n";
+    return 0;
+}
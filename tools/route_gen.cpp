@@ -0,0 +1,218 @@
+// Synthetic route generator: writes objects.ref, route1.map, DMD models and
+// BMP textures for scale testing without licensed route data. Placements
+// follow a gently curving track, the same seed always gives the same route.
+//
+//   route_gen <output directory> [--placements N] [--reuse R] [--models N] [--textures N]
+//             [--grid-min N] [--grid-max N] [--density N] [--spread M] [--texture-size N] [--seed N]
+//             [--buildings N] [--building-ratio F]
+
+#include "DMD_Writer.h"
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// std distributions differ between standard libraries, mt19937 itself does not
+class Random
+{
+public:
+    explicit Random(uint32_t seed) : engine(seed) {}
+
+    double uniform(double min, double max) { return min + (max - min) * (engine() >> 8) * (1.0 / 16777216.0); }
+    uint32_t index(uint32_t count) { return static_cast<uint32_t>(uniform(0.0, count)) % count; }
+
+private:
+    std::mt19937 engine;
+};
+
+static void write_u16(std::ostream& output, uint16_t value)
+{
+    const char bytes[2] = {static_cast<char>(value & 0xff), static_cast<char>(value >> 8)};
+    output.write(bytes, 2);
+}
+
+static void write_u32(std::ostream& output, uint32_t value)
+{
+    write_u16(output, static_cast<uint16_t>(value & 0xffff));
+    write_u16(output, static_cast<uint16_t>(value >> 16));
+}
+
+// 24 bit uncompressed BMP, a checker pattern tinted per texture
+static bool writeTexture(const std::filesystem::path& file, uint32_t size, uint32_t textureIndex)
+{
+    std::ofstream output(file, std::ios::binary);
+
+    const uint32_t rowSize = (size * 3 + 3) & ~3u;
+    const uint32_t imageSize = rowSize * size;
+
+    output.write("BM", 2);
+    write_u32(output, 54 + imageSize);
+    write_u32(output, 0);
+    write_u32(output, 54);
+
+    write_u32(output, 40);
+    write_u32(output, size);
+    write_u32(output, size);
+    write_u16(output, 1);
+    write_u16(output, 24);
+    write_u32(output, 0);
+    write_u32(output, imageSize);
+    write_u32(output, 2835);
+    write_u32(output, 2835);
+    write_u32(output, 0);
+    write_u32(output, 0);
+
+    const uint8_t tint[3] = {static_cast<uint8_t>(64 + (textureIndex * 37) % 192), static_cast<uint8_t>(64 + (textureIndex * 71) % 192),
+                             static_cast<uint8_t>(64 + (textureIndex * 113) % 192)};
+    const uint32_t cell = std::max(1u, size / 8);
+
+    std::vector<char> row(rowSize, 0);
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            const bool light = ((x / cell) + (y / cell)) % 2 == 0;
+            for (uint32_t channel = 0; channel < 3; ++channel)
+            {
+                row[x * 3 + channel] = static_cast<char>(light ? tint[channel] : tint[channel] / 2);
+            }
+        }
+        output.write(row.data(), row.size());
+    }
+
+    return static_cast<bool>(output);
+}
+
+int main(int argc, char* argv[])
+{
+    vsg::CommandLine arguments(&argc, argv);
+    const uint64_t numPlacements = arguments.value<uint64_t>(100000, "--placements");
+    const double reuse = std::max(1.0, arguments.value<double>(100.0, "--reuse"));
+    const uint32_t numLabels = static_cast<uint32_t>(std::max<uint64_t>(1, static_cast<uint64_t>(numPlacements / reuse)));
+    const uint32_t numModels = std::max(1u, std::min(numLabels, arguments.value<uint32_t>(256, "--models")));
+    const uint32_t numTextures = std::max(1u, std::min(numLabels, arguments.value<uint32_t>(64, "--textures")));
+    const uint32_t gridMin = std::max(1u, arguments.value<uint32_t>(2, "--grid-min"));
+    const uint32_t gridMax = std::max(gridMin, std::min(64u, arguments.value<uint32_t>(16, "--grid-max")));
+    const double density = std::max(1.0, arguments.value<double>(200.0, "--density")); // placements per km of track
+    const double spread = arguments.value<double>(60.0, "--spread");                   // metres either side of the track
+    const uint32_t textureSize = std::max(2u, arguments.value<uint32_t>(64, "--texture-size"));
+    const uint32_t seed = arguments.value<uint32_t>(1, "--seed");
+    const uint32_t numBuildings = arguments.value<uint32_t>(0, "--buildings"); // box models marked [occluder]
+    const double buildingRatio = std::clamp(arguments.value<double>(0.1, "--building-ratio"), 0.0, 1.0);
+    if (arguments.errors() || argc < 2)
+    {
+        arguments.writeErrorMessages(std::cerr);
+        std::cerr << "Usage: route_gen <output directory> [options]" << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path routeDirectory(argv[1]);
+    std::filesystem::create_directories(routeDirectory / "models");
+    std::filesystem::create_directories(routeDirectory / "textures");
+
+    Random random(seed);
+
+    for (uint32_t model = 0; model < numModels; ++model)
+    {
+        const uint32_t grid = gridMin + random.index(gridMax - gridMin + 1);
+        const float size = static_cast<float>(random.uniform(2.0, 20.0));
+        if (!dmd_write((routeDirectory / "models" / vsg::make_string("model_", model, ".dmd")).string(), dmd_grid(grid, grid, size)))
+        {
+            std::cerr << "Failed to write model " << model << std::endl;
+            return 1;
+        }
+    }
+
+    for (uint32_t building = 0; building < numBuildings; ++building)
+    {
+        const float width = static_cast<float>(random.uniform(20.0, 60.0));
+        const float depth = static_cast<float>(random.uniform(10.0, 20.0));
+        const float height = static_cast<float>(random.uniform(8.0, 25.0));
+        if (!dmd_write((routeDirectory / "models" / vsg::make_string("building_", building, ".dmd")).string(), dmd_box(width, depth, height)))
+        {
+            std::cerr << "Failed to write building " << building << std::endl;
+            return 1;
+        }
+    }
+
+    for (uint32_t texture = 0; texture < numTextures; ++texture)
+    {
+        if (!writeTexture(routeDirectory / "textures" / vsg::make_string("texture_", texture, ".bmp"), textureSize, texture))
+        {
+            std::cerr << "Failed to write texture " << texture << std::endl;
+            return 1;
+        }
+    }
+
+    // the loader appends these paths to the route directory
+    std::ofstream objectsRef(routeDirectory / "objects.ref");
+    objectsRef << "; generated by route_gen, seed " << seed << '\n';
+    for (uint32_t label = 0; label < numLabels; ++label)
+    {
+        if (label == 0)
+        {
+            objectsRef << "[mipmap]\n[smooth]\n";
+        }
+        else if (label == numLabels / 2)
+        {
+            objectsRef << "[not_mipmap]\n[not_smooth]\n";
+        }
+        objectsRef << "obj_" << label << " /models/model_" << random.index(numModels) << ".dmd /textures/texture_" << random.index(numTextures) << ".bmp\n";
+    }
+    if (numBuildings > 0)
+    {
+        objectsRef << "[occluder]\n";
+        for (uint32_t building = 0; building < numBuildings; ++building)
+        {
+            objectsRef << "bld_" << building << " /models/building_" << building << ".dmd /textures/texture_" << random.index(numTextures) << ".bmp\n";
+        }
+    }
+
+    // the track heads along x and turns slowly, placements scatter around it
+    std::ofstream routeMap(routeDirectory / "route1.map");
+    routeMap.precision(10);
+
+    const double step = 1000.0 / density;
+    double heading = 0.0;
+    vsg::dvec2 position(0.0, 0.0);
+    for (uint64_t placement = 0; placement < numPlacements; ++placement)
+    {
+        heading += random.uniform(-0.002, 0.002) * step;
+        position += vsg::dvec2(std::cos(heading), std::sin(heading)) * step;
+
+        const double offset = random.uniform(-spread, spread);
+        const vsg::dvec2 side(-std::sin(heading), std::cos(heading));
+        const vsg::dvec2 location = position + side * offset;
+
+        // buildings line the track facing it, no extra draws without them so older seeds give the same route
+        if (numBuildings > 0 && random.uniform(0.0, 1.0) < buildingRatio)
+        {
+            const double sign = offset < 0.0 ? -1.0 : 1.0;
+            const vsg::dvec2 site = position + side * (sign * random.uniform(15.0, std::max(15.0, spread)));
+            routeMap << "bld_" << random.index(numBuildings) << ',' << site.x << ',' << site.y << ",0,"
+                     << "0,0," << vsg::degrees(-heading) << ";\n";
+            continue;
+        }
+
+        routeMap << "obj_" << random.index(numLabels) << ',' << location.x << ',' << location.y << ",0,"
+                 << "0,0," << random.uniform(0.0, 360.0) << ";\n";
+    }
+
+    if (!objectsRef || !routeMap)
+    {
+        std::cerr << "Failed to write the route files" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << numPlacements << " placements of " << numLabels << " labels, " << numModels << " models and "
+              << numTextures << " textures to " << routeDirectory.string() << std::endl;
+    return 0;
+}